@@ -51,7 +51,9 @@ internal class CommandLineActions
             "list-package",
             "extract-single-file",
             "extract-package",
-            "extract-packages"
+            "extract-packages",
+            "verify-package",
+            "diff-packages"
         };
 
         string[] graphicsActions =
@@ -129,7 +131,7 @@ internal class CommandLineActions
         }
 
         SourcePath = TryToValidatePath(args.Source);
-        if (args.Action != "list-package" && args.Action != "build-vt")
+        if (args.Action != "list-package" && args.Action != "build-vt" && args.Action != "verify-package")
         {
             DestinationPath = TryToValidatePath(args.Destination);
         }
@@ -195,6 +197,18 @@ internal class CommandLineActions
                 break;
             }
 
+            case "verify-package":
+            {
+                CommandLinePackageProcessor.Verify();
+                break;
+            }
+
+            case "diff-packages":
+            {
+                CommandLinePackageProcessor.Diff();
+                break;
+            }
+
             case "convert-model":
             {
                 CommandLineGR2Processor.UpdateExporterSettings();
@@ -82,7 +82,7 @@ public class CommandLineArguments
     [EnumeratedValueArgument(typeof(string), 'a', "action",
         Description = "Set action to execute",
         DefaultValue = "extract-package",
-        AllowedValues = "create-package;list-package;extract-single-file;extract-package;extract-packages;convert-model;convert-models;convert-resource;convert-resources;convert-loca;build-vt",
+        AllowedValues = "create-package;list-package;extract-single-file;extract-package;extract-packages;verify-package;diff-packages;convert-model;convert-models;convert-resource;convert-resources;convert-loca;build-vt",
         ValueOptional = false,
         Optional = false
     )]
@@ -170,6 +170,36 @@ public class CommandLineArguments
     )]
     public bool UseRegex;
 
+    // @formatter:off
+    [SwitchArgument("convert-physics", false,
+        Description = "Convert PhysX resources between binary and XML when extracting or creating packages",
+        Optional = true
+    )]
+    public bool ConvertPhysics;
+
+    // @formatter:off
+    [SwitchArgument("incremental", false,
+        Description = "Reuse unchanged compressed files from the existing package when creating a package",
+        Optional = true
+    )]
+    public bool Incremental;
+
+    // @formatter:off
+    [SwitchArgument("deduplicate", false,
+        Description = "Store identical files only once when creating a package",
+        Optional = true
+    )]
+    public bool Deduplicate;
+
+    // @formatter:off
+    [ValueArgument(typeof(int), "max-concurrent-writes",
+        Description = "Set the number of files written at the same time when extracting multiple packages (0 = half of the worker threads)",
+        DefaultValue = 0,
+        ValueOptional = false,
+        Optional = true
+    )]
+    public int MaxConcurrentWrites;
+
     // @formatter:off
     [ValueArgument(typeof(string), "vt-root",
         Description = "Tileset build mod root path",
@@ -28,6 +28,108 @@ internal class CommandLinePackageProcessor
         }
     }
 
+    public static void Verify()
+    {
+        if (CommandLineActions.SourcePath == null)
+        {
+            CommandLineLogger.LogFatal("Cannot verify package without source path", 1);
+        }
+        else
+        {
+            VerifyPackage(CommandLineActions.SourcePath);
+        }
+    }
+
+    private static void VerifyPackage(string packagePath)
+    {
+        PackageVerificationResult result;
+        try
+        {
+            var reader = new PackageReader();
+            using var package = reader.Read(packagePath);
+            result = new PackageVerifier().Verify(package);
+        }
+        catch (NotAPackageException)
+        {
+            CommandLineLogger.LogError("Failed to verify package because the package is not an Original Sin package or savegame archive");
+            return;
+        }
+        catch (Exception e)
+        {
+            CommandLineLogger.LogFatal($"Failed to verify package: {e.Message}", 2);
+            CommandLineLogger.LogTrace($"{e.StackTrace}");
+            return;
+        }
+
+        foreach (var error in result.Errors)
+        {
+            CommandLineLogger.LogError($"{error.File.Name}: {error.Message}");
+        }
+
+        CommandLineLogger.LogInfo($"Verified {result.NumFiles} files ({result.CompressedBytes} bytes) in {result.Elapsed.TotalSeconds:0.00}s, {result.GigabytesPerSecond:0.00} GB/s");
+
+        if (result.Errors.Count > 0)
+        {
+            CommandLineLogger.LogFatal($"Package verification failed: {result.Errors.Count} corrupted files", 3);
+        }
+        else
+        {
+            CommandLineLogger.LogInfo("Package verified successfully.");
+        }
+    }
+
+    public static void Diff()
+    {
+        if (CommandLineActions.SourcePath == null || CommandLineActions.DestinationPath == null)
+        {
+            CommandLineLogger.LogFatal("Cannot compare packages without source and destination paths", 1);
+        }
+        else
+        {
+            DiffPackages(CommandLineActions.SourcePath, CommandLineActions.DestinationPath);
+        }
+    }
+
+    private static void DiffPackages(string oldPackagePath, string newPackagePath)
+    {
+        PackageComparisonResult result;
+        try
+        {
+            using var oldPackage = new PackageReader().Read(oldPackagePath);
+            using var newPackage = new PackageReader().Read(newPackagePath);
+            result = new PackageComparer().Compare(oldPackage, newPackage);
+        }
+        catch (NotAPackageException)
+        {
+            CommandLineLogger.LogError("Failed to compare packages because one of them is not an Original Sin package or savegame archive");
+            return;
+        }
+        catch (Exception e)
+        {
+            CommandLineLogger.LogFatal($"Failed to compare packages: {e.Message}", 2);
+            CommandLineLogger.LogTrace($"{e.StackTrace}");
+            return;
+        }
+
+        foreach (var file in result.Added)
+        {
+            Console.WriteLine($"A\t{file.Name}");
+        }
+
+        foreach (var file in result.Removed)
+        {
+            Console.WriteLine($"D\t{file.Name}");
+        }
+
+        foreach (var change in result.Changed)
+        {
+            Console.WriteLine($"M\t{change.NewFile.Name}\t{change.Reason}");
+        }
+
+        CommandLineLogger.LogInfo($"{result.Added.Count} added, {result.Removed.Count} removed, {result.Changed.Count} changed; "
+            + $"compared {result.NumCompared} files ({result.NumContentCompared} by contents) in {result.Elapsed.TotalSeconds:0.00}s");
+    }
+
     public static void ExtractSingleFile()
     {
         ExtractSingleFile(CommandLineActions.SourcePath, CommandLineActions.DestinationPath, CommandLineActions.PackagedFilePath);
@@ -116,14 +218,52 @@ internal class CommandLinePackageProcessor
     public static void BatchExtract(Func<PackagedFileInfo, bool> filter = null)
     {
         string[] files = Directory.GetFiles(CommandLineActions.SourcePath, $"*.{Args.InputFormat}");
+        List<PackageExtractionJob> jobs = [];
 
-        foreach (string file in files)
+        try
         {
-            string extractionPath = GetExtractionPath(file, CommandLineActions.DestinationPath);
+            foreach (string file in files)
+            {
+                try
+                {
+                    var package = new PackageReader().Read(file);
+                    jobs.Add(new PackageExtractionJob
+                    {
+                        Package = package,
+                        OutputPath = GetExtractionPath(file, CommandLineActions.DestinationPath)
+                    });
+                    CommandLineLogger.LogDebug($"Using extraction path: {jobs[^1].OutputPath}");
+                }
+                catch (NotAPackageException)
+                {
+                    CommandLineLogger.LogError($"Skipping {file} because it is not an Original Sin package or savegame archive");
+                }
+                catch (Exception e)
+                {
+                    CommandLineLogger.LogError($"Skipping {file} because it could not be opened: {e.Message}");
+                    CommandLineLogger.LogTrace($"{e.StackTrace}");
+                }
+            }
 
-            CommandLineLogger.LogInfo($"Extracting package: {file}");
+            CommandLineLogger.LogInfo($"Extracting {jobs.Count} packages from: {CommandLineActions.SourcePath}");
 
-            ExtractPackageResource(file, extractionPath, filter);
+            var extractor = new PackageBatchExtractor
+            {
+                ConvertPhysics = Args.ConvertPhysics,
+                MaxConcurrentWrites = Args.MaxConcurrentWrites
+            };
+            var result = extractor.Extract(jobs, filter);
+
+            CommandLineLogger.LogInfo($"Extracted {result.NumFiles} files ({result.Bytes} bytes) from {result.NumPackages} packages in {result.Elapsed.TotalSeconds:0.00}s, {result.GigabytesPerSecond:0.00} GB/s");
+        }
+        catch (Exception e)
+        {
+            CommandLineLogger.LogFatal($"Failed to extract packages: {e.Message}", 2);
+            CommandLineLogger.LogTrace($"{e.StackTrace}");
+        }
+        finally
+        {
+            jobs.ForEach(job => job.Package.Dispose());
         }
     }
 
@@ -147,12 +287,30 @@ internal class CommandLinePackageProcessor
         Dictionary<string, object> compressionOptions = CommandLineArguments.GetCompressionOptions(Path.GetExtension(file)?.ToLower() == ".lsv" ? "zlib" : Args.PakCompressionMethod, build.Version);
         build.Compression = (CompressionMethod)compressionOptions["Compression"];
         build.CompressionLevel = (LSCompressionLevel)compressionOptions["CompressionLevel"];
+        build.Deduplicate = Args.Deduplicate;
 
         CommandLineLogger.LogDebug($"Using compression method: {build.Compression} (build.CompressionLevel)");
 
         var packager = new Packager();
+        packager.ConvertPhysics = Args.ConvertPhysics;
+        packager.Incremental = Args.Incremental;
         packager.CreatePackage(file, CommandLineActions.SourcePath, build).Wait();
 
+        if (packager.WriteStats?.ReusedFiles > 0)
+        {
+            CommandLineLogger.LogInfo($"Reused {packager.WriteStats.ReusedFiles} unchanged files ({packager.WriteStats.ReusedBytes} bytes) from the previous package.");
+        }
+
+        foreach (var error in packager.WriteStats?.ReuseErrors ?? [])
+        {
+            CommandLineLogger.LogWarn($"Could not reuse {error}; the file was compressed again.");
+        }
+
+        if (packager.WriteStats?.DeduplicatedFiles > 0)
+        {
+            CommandLineLogger.LogInfo($"Deduplicated {packager.WriteStats.DeduplicatedFiles} files, saving {packager.WriteStats.DeduplicatedBytes} bytes.");
+        }
+
         CommandLineLogger.LogInfo("Package created successfully.");
     }
 
@@ -169,6 +327,7 @@ internal class CommandLinePackageProcessor
         {
 #endif
             var packager = new Packager();
+            packager.ConvertPhysics = Args.ConvertPhysics;
 
             string extractionPath = GetExtractionPath(folder, CommandLineActions.DestinationPath);
 
@@ -144,6 +144,57 @@ public static class BinUtils
         writer.Write(writeBuffer);
     }
 
+    // Bulk struct I/O for unmanaged types: the data is copied straight between the stream and the memory
+    // of the elements, without a temporary buffer or marshalling each element. Only usable for types whose
+    // in-memory layout is the file layout, i.e. no bool/char fields or MarshalAs arrays.
+    public static void ReadStructs<T>(BinaryReader reader, Span<T> elements) where T : unmanaged
+    {
+        reader.BaseStream.ReadExactly(MemoryMarshal.AsBytes(elements));
+    }
+
+    public static void ReadStruct<T>(BinaryReader reader, out T element) where T : unmanaged
+    {
+        element = default;
+        ReadStructs(reader, new Span<T>(ref element));
+    }
+
+    public static unsafe void ReadStructs<T>(MemoryMappedViewAccessor view, long offset, Span<T> elements) where T : unmanaged
+    {
+        var size = (long)sizeof(T) * elements.Length;
+        if (offset < 0 || offset + size > view.Capacity)
+        {
+            throw new ArgumentOutOfRangeException(nameof(offset), $"Range {offset}+{size} is outside of the view");
+        }
+
+        var handle = view.SafeMemoryMappedViewHandle;
+        byte* ptr = null;
+        handle.AcquirePointer(ref ptr);
+        try
+        {
+            new ReadOnlySpan<byte>(ptr + view.PointerOffset + offset, (int)size).CopyTo(MemoryMarshal.AsBytes(elements));
+        }
+        finally
+        {
+            handle.ReleasePointer();
+        }
+    }
+
+    public static void ReadStruct<T>(MemoryMappedViewAccessor view, long offset, out T element) where T : unmanaged
+    {
+        element = default;
+        ReadStructs(view, offset, new Span<T>(ref element));
+    }
+
+    public static void WriteStructs<T>(BinaryWriter writer, ReadOnlySpan<T> elements) where T : unmanaged
+    {
+        writer.Write(MemoryMarshal.AsBytes(elements));
+    }
+
+    public static void WriteStruct<T>(BinaryWriter writer, T element) where T : unmanaged
+    {
+        WriteStructs(writer, new ReadOnlySpan<T>(in element));
+    }
+
     public static unsafe String NullTerminatedBytesToString(byte[] b)
     {
         fixed (byte* ptr = b)
@@ -2,74 +2,9 @@
 using K4os.Compression.LZ4.Streams;
 using System.Buffers;
 using System.IO.Compression;
-using System.IO.MemoryMappedFiles;
 
 namespace LSLib.LS;
 
-
-public class LZ4DecompressionStream : Stream
-{
-    private readonly MemoryMappedViewAccessor View;
-    private readonly long Offset;
-    private readonly int Size;
-    private readonly int DecompressedSize;
-    private MemoryStream Decompressed;
-
-    public LZ4DecompressionStream(MemoryMappedViewAccessor view, long offset, int size, int decompressedSize)
-    {
-        View = view;
-        Offset = offset;
-        Size = size;
-        DecompressedSize = decompressedSize;
-    }
-
-    private void DoDecompression()
-    {
-        var compressed = new byte[Size];
-        View.ReadArray(Offset, compressed, 0, Size);
-
-        var decompressed = new byte[DecompressedSize];
-        int length = LZ4Codec.Decode(compressed, 0, compressed.Length, decompressed, 0, DecompressedSize);
-        if (length != DecompressedSize)
-        {
-            throw new Exception("Failed to decompress LZ4 stream");
-        }
-        Decompressed = new MemoryStream(decompressed);
-    }
-
-    public override bool CanRead { get { return true; } }
-    public override bool CanSeek { get { return false; } }
-
-    public override int Read(byte[] buffer, int offset, int count)
-    {
-        if (Decompressed == null)
-        {
-            DoDecompression();
-        }
-
-        return Decompressed.Read(buffer, offset, count);
-    }
-
-    public override long Seek(long offset, SeekOrigin origin)
-    {
-        throw new NotSupportedException();
-    }
-
-
-    public override long Position
-    {
-        get { return Decompressed?.Position ?? 0; }
-        set { throw new NotSupportedException(); }
-    }
-
-    public override bool CanTimeout { get { return false; } }
-    public override bool CanWrite { get { return false; } }
-    public override long Length { get { return DecompressedSize; } }
-    public override void SetLength(long value) { throw new NotSupportedException(); }
-    public override void Write(byte[] buffer, int offset, int count) { throw new NotSupportedException(); }
-    public override void Flush() { }
-}
-
 public static class CompressionHelpers
 {
     public static CompressionFlags MakeCompressionFlags(CompressionMethod method, LSCompressionLevel level)
@@ -145,11 +80,10 @@ public static class CompressionHelpers
         }
     }
 
-    public static Stream Decompress(MemoryMappedFile file, MemoryMappedViewAccessor view, long sourceOffset,
-        int sourceSize, int decompressedSize, CompressionFlags compression)
+    // Decompresses from memory that is already mapped, without creating a new view for each file
+    public static unsafe Stream Decompress(UnmanagedMemoryStream source, int decompressedSize, CompressionFlags compression)
     {
-        // MemoryMappedView considers a size of 0 to mean "entire stream"
-        if (sourceSize == 0)
+        if (source.Length == 0)
         {
             return new MemoryStream();
         }
@@ -157,18 +91,27 @@ public static class CompressionHelpers
         switch (compression.Method())
         {
             case CompressionMethod.None:
-                return file.CreateViewStream(sourceOffset, sourceSize, MemoryMappedFileAccess.Read);
+                return source;
 
             case CompressionMethod.Zlib:
-                var sourceStream = file.CreateViewStream(sourceOffset, sourceSize, MemoryMappedFileAccess.Read);
-                return new ZLibStream(sourceStream, CompressionMode.Decompress);
+                return new ZLibStream(source, CompressionMode.Decompress);
 
             case CompressionMethod.LZ4:
-                return new LZ4DecompressionStream(view, sourceOffset, sourceSize, decompressedSize);
+                {
+                    var compressed = new ReadOnlySpan<byte>(source.PositionPointer, (int)source.Length);
+                    var decompressed = new byte[decompressedSize];
+                    int length = LZ4Codec.Decode(compressed, decompressed);
+                    source.Dispose();
+                    if (length != decompressedSize)
+                    {
+                        throw new InvalidDataException("Failed to decompress LZ4 stream");
+                    }
+
+                    return new MemoryStream(decompressed, false);
+                }
 
             case CompressionMethod.Zstd:
-                var zstdStream = file.CreateViewStream(sourceOffset, sourceSize, MemoryMappedFileAccess.Read);
-                return new ZstdSharp.DecompressionStream(zstdStream);
+                return new ZstdSharp.DecompressionStream(source, leaveOpen: false);
 
             default:
                 throw new InvalidDataException($"No decompressor found for this format: {compression}");
@@ -0,0 +1,217 @@
+﻿using System.Buffers;
+using System.Collections.Concurrent;
+using System.Diagnostics;
+using System.Runtime.ExceptionServices;
+
+namespace LSLib.LS;
+
+public class PackageExtractionJob
+{
+    public Package Package;
+    public string OutputPath;
+}
+
+public class PackageBatchExtractionResult
+{
+    public int NumPackages;
+    public int NumFiles;
+    public long Bytes;
+    public TimeSpan Elapsed;
+
+    public double GigabytesPerSecond => Elapsed.TotalSeconds > 0 ? Bytes / Elapsed.TotalSeconds / 1e9 : 0.0;
+}
+
+// Extracts several packages at once. The files of all packages are pooled and handed out largest first
+// to a single set of workers, so a few large files don't leave a long tail at the end of the batch and
+// small packages don't leave workers idle. Decompression is unbounded (up to the number of workers),
+// while the number of files being written at the same time is capped separately.
+public class PackageBatchExtractor
+{
+    public Packager.ProgressUpdateDelegate ProgressUpdate = delegate { };
+
+    // Convert PhysX collections to XML when extracting
+    public bool ConvertPhysics = false;
+
+    // Number of files extracted concurrently; 0 uses one worker per processor
+    public int MaxParallelism = 0;
+
+    // Number of files written concurrently; 0 allows half of the workers to write at the same time
+    public int MaxConcurrentWrites = 0;
+
+    // Files up to this size are decompressed into memory before waiting for a write slot;
+    // larger ones are decompressed while writing to keep memory use bounded
+    private const int MaxBufferedFileSize = 0x1000000;
+
+    private readonly struct ExtractionTask(PackagedFileInfo file, string outputPath)
+    {
+        public readonly PackagedFileInfo File = file;
+        public readonly string OutputPath = outputPath;
+    }
+
+    public PackageBatchExtractionResult Extract(IList<PackageExtractionJob> jobs, Func<PackagedFileInfo, bool> filter = null)
+    {
+        var options = new ParallelOptions
+        {
+            MaxDegreeOfParallelism = MaxParallelism > 0 ? MaxParallelism : Environment.ProcessorCount
+        };
+
+        var timer = Stopwatch.StartNew();
+
+        // File lists are parsed on first access, so enumerate them in parallel too
+        var packageFiles = new List<PackagedFileInfo>[jobs.Count];
+        RunParallel(() => Parallel.For(0, jobs.Count, options, i =>
+        {
+            var files = jobs[i].Package.Files.FindAll(f => !f.IsDeletion() && (filter == null || filter(f)));
+            Packager.CreateOutputDirectories(files, jobs[i].OutputPath);
+            packageFiles[i] = files;
+        }));
+
+        // Packages extracted to the same folder can contain the same path. Only the file of the last
+        // package is kept, which is what extracting the packages one after another would leave behind.
+        var comparer = OperatingSystem.IsWindows() ? StringComparer.OrdinalIgnoreCase : StringComparer.Ordinal;
+        var outputIndices = new Dictionary<string, int>(comparer);
+        List<ExtractionTask> tasks = [];
+        for (var i = 0; i < jobs.Count; i++)
+        {
+            foreach (var file in packageFiles[i])
+            {
+                var task = new ExtractionTask(file, Path.GetFullPath(Path.Join(jobs[i].OutputPath, file.Name)));
+                if (outputIndices.TryGetValue(task.OutputPath, out var index))
+                {
+                    tasks[index] = task;
+                }
+                else
+                {
+                    outputIndices.Add(task.OutputPath, tasks.Count);
+                    tasks.Add(task);
+                }
+            }
+        }
+
+        tasks.Sort((a, b) => b.File.Size().CompareTo(a.File.Size()));
+        long totalSize = tasks.Sum(t => (long)t.File.Size());
+        long currentSize = 0;
+
+        var maxWrites = MaxConcurrentWrites > 0 ? MaxConcurrentWrites : Math.Max(1, options.MaxDegreeOfParallelism / 2);
+        using var writeSlots = new SemaphoreSlim(maxWrites);
+
+        // Workers finish out of order; progress is reported on the calling thread
+        using var completed = new BlockingCollection<int>();
+        var extraction = Task.Run(() =>
+        {
+            try
+            {
+                // Hand out files one at a time so the largest ones are started first
+                var indices = Partitioner.Create(Enumerable.Range(0, tasks.Count), EnumerablePartitionerOptions.NoBuffering);
+                RunParallel(() => Parallel.ForEach(indices, options, index =>
+                {
+                    ExtractFile(tasks[index], writeSlots);
+                    completed.Add(index);
+                }));
+            }
+            finally
+            {
+                completed.CompleteAdding();
+            }
+        });
+
+        foreach (var index in completed.GetConsumingEnumerable())
+        {
+            currentSize += (long)tasks[index].File.Size();
+            ProgressUpdate(tasks[index].File.Name, currentSize, totalSize);
+        }
+
+        extraction.GetAwaiter().GetResult();
+        timer.Stop();
+
+        return new PackageBatchExtractionResult
+        {
+            NumPackages = jobs.Count,
+            NumFiles = tasks.Count,
+            Bytes = totalSize,
+            Elapsed = timer.Elapsed
+        };
+    }
+
+    private static void RunParallel(Action action)
+    {
+        try
+        {
+            action();
+        }
+        catch (AggregateException e) when (e.InnerExceptions.Count == 1)
+        {
+            ExceptionDispatchInfo.Capture(e.InnerException).Throw();
+        }
+    }
+
+    private void ExtractFile(ExtractionTask task, SemaphoreSlim writeSlots)
+    {
+        var file = task.File;
+        if (ConvertPhysics && file.Name.EndsWith(".bin", StringComparison.OrdinalIgnoreCase))
+        {
+            writeSlots.Wait();
+            try
+            {
+                Packager.ExtractPhysicsResource(file, task.OutputPath);
+            }
+            finally
+            {
+                writeSlots.Release();
+            }
+            return;
+        }
+
+        // Spans can't cover entries over 2 GB; those are streamed below
+        if (file.HasDirectContents && file.Size() <= int.MaxValue)
+        {
+            WriteFile(task.OutputPath, file.GetContentSpan(), writeSlots);
+            return;
+        }
+
+        if (file.Size() > (ulong)MaxBufferedFileSize)
+        {
+            writeSlots.Wait();
+            try
+            {
+                using var outFile = File.Open(task.OutputPath, FileMode.Create, FileAccess.Write);
+                Packager.CopyContents(file, outFile);
+            }
+            finally
+            {
+                writeSlots.Release();
+            }
+            return;
+        }
+
+        var size = (int)file.Size();
+        var buffer = ArrayPool<byte>.Shared.Rent(size);
+        try
+        {
+            using (var inStream = file.CreateContentReader())
+            {
+                inStream.ReadExactly(buffer, 0, size);
+            }
+
+            WriteFile(task.OutputPath, buffer.AsSpan(0, size), writeSlots);
+        }
+        finally
+        {
+            ArrayPool<byte>.Shared.Return(buffer);
+        }
+    }
+
+    private static void WriteFile(string path, ReadOnlySpan<byte> contents, SemaphoreSlim writeSlots)
+    {
+        writeSlots.Wait();
+        try
+        {
+            using var outFile = File.Open(path, FileMode.Create, FileAccess.Write);
+            outFile.Write(contents);
+        }
+        finally
+        {
+            writeSlots.Release();
+        }
+    }
+}
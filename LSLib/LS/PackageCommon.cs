@@ -1,5 +1,8 @@
+using System.Buffers;
+using System.Collections.Concurrent;
 using System.IO;
 using System.IO.MemoryMappedFiles;
+using System.Runtime.ExceptionServices;
 using System.Xml.Linq;
 using LSLib.LS.Enums;
 
@@ -10,9 +13,10 @@ public class PackagedFileInfo : PackagedFileInfoCommon
     public Package Package;
     public MemoryMappedFile PackageFile;
     public MemoryMappedViewAccessor PackageView;
+    internal MappedPart PackageMapping;
     public bool Solid;
     public ulong SolidOffset;
-    public Stream SolidStream;
+    public SolidSegment SolidSegment;
 
     public UInt64 Size() => Flags.Method() == CompressionMethod.None ? SizeOnDisk : UncompressedSize;
 
@@ -25,22 +29,56 @@ public class PackagedFileInfo : PackagedFileInfoCommon
 
         if (Solid)
         {
-            SolidStream.Seek((long)SolidOffset, SeekOrigin.Begin);
-            return new ReadOnlySubstream(SolidStream, (long)SolidOffset, (long)UncompressedSize);
+            // Each reader gets its own position over the shared decompressed buffer
+            return new MemoryStream(SolidSegment.Contents, (int)SolidOffset, (int)UncompressedSize, false);
         }
         else
         {
-            return CompressionHelpers.Decompress(PackageFile, PackageView, (long)OffsetInFile, (int)SizeOnDisk, (int)UncompressedSize, Flags);
+            var source = PackageMapping.CreateStream((long)OffsetInFile, (long)SizeOnDisk);
+            return CompressionHelpers.Decompress(source, (int)UncompressedSize, Flags);
         }
     }
 
-    internal static PackagedFileInfo CreateFromEntry(Package package, ILSPKFile entry, MemoryMappedFile file, MemoryMappedViewAccessor view)
+    // True if the contents can be accessed in place through GetContentSpan()/GetContentMemory()
+    public bool HasDirectContents => !IsDeletion() && (Solid || Flags.Method() == CompressionMethod.None);
+
+    // Contents of an uncompressed or solid entry without copying. Uncompressed entries point directly
+    // into the mapped archive part, so the span is only valid while the package is open.
+    public ReadOnlySpan<byte> GetContentSpan()
+    {
+        if (!HasDirectContents)
+        {
+            throw new InvalidOperationException("Only uncompressed and solid files can be accessed directly");
+        }
+
+        return Solid ? SolidContents().Span : PackageMapping.GetSpan((long)OffsetInFile, (int)SizeOnDisk);
+    }
+
+    public ReadOnlyMemory<byte> GetContentMemory()
+    {
+        if (!HasDirectContents)
+        {
+            throw new InvalidOperationException("Only uncompressed and solid files can be accessed directly");
+        }
+
+        return Solid ? SolidContents() : PackageMapping.GetMemory((long)OffsetInFile, (int)SizeOnDisk);
+    }
+
+    // Decompressed contents of a solid entry; decompresses the archive on first access
+    public ReadOnlyMemory<byte> SolidContents()
+    {
+        return SolidSegment.Contents.AsMemory((int)SolidOffset, (int)UncompressedSize);
+    }
+
+    internal static PackagedFileInfo CreateFromEntry<TFile>(Package package, in TFile entry, int part)
+        where TFile : struct, ILSPKFile
     {
         var info = new PackagedFileInfo
         {
             Package = package,
-            PackageFile = file,
-            PackageView = view,
+            PackageFile = package.Parts[part],
+            PackageView = package.Views[part],
+            PackageMapping = package.MappedParts[part],
             Solid = false
         };
 
@@ -48,11 +86,11 @@ public class PackagedFileInfo : PackagedFileInfoCommon
         return info;
     }
 
-    internal void MakeSolid(ulong solidOffset, Stream solidStream)
+    internal void MakeSolid(ulong solidOffset, SolidSegment segment)
     {
         Solid = true;
         SolidOffset = solidOffset;
-        SolidStream = solidStream;
+        SolidSegment = segment;
     }
 
     public bool IsDeletion()
@@ -121,6 +159,14 @@ public class PackageBuildData
     public List<PackageBuildInputFile> Files { get; set; } = [];
     public bool ExcludeHidden { get; set; } = true;
     public byte Priority { get; set; } = 0;
+    // Number of compression workers; 0 uses one worker per processor
+    public int CompressionThreads { get; set; } = 0;
+    // Maximum number of uncompressed bytes read ahead of the writer
+    public long MaxInFlightBytes { get; set; } = 0x10000000;
+    // Previously built package; unchanged files are copied from it instead of being recompressed
+    public Package PreviousPackage { get; set; } = null;
+    // Store the body of identical files only once (non-solid packages only)
+    public bool Deduplicate { get; set; } = false;
 
 }
 
@@ -130,6 +176,20 @@ public class Packager
 
     public ProgressUpdateDelegate ProgressUpdate = delegate { };
 
+    // Convert PhysX collections to XML when extracting, and back to binary when building packages
+    public bool ConvertPhysics = false;
+
+    // Number of files extracted concurrently; 0 uses one worker per processor
+    public int MaxParallelism = 0;
+
+    // Reuse compressed files from the existing package at the output path when building
+    public bool Incremental = false;
+
+    // Statistics of the last package built
+    public PackageWriteStats WriteStats;
+
+    private const int CopyBufferSize = 0x100000;
+
     private void WriteProgressUpdate(PackageBuildInputFile file, long numerator, long denominator)
     {
         ProgressUpdate(file.Path, numerator, denominator);
@@ -149,23 +209,158 @@ public class Packager
             files = files.FindAll(obj => filter(obj));
         }
 
+        CreateOutputDirectories(files, outputPath);
+
         long totalSize = files.Sum(p => (long)p.Size());
         long currentSize = 0;
 
-        foreach (var file in files)
+        // Workers finish out of order; progress is reported on the calling thread in package order
+        using var completed = new BlockingCollection<int>();
+        var extraction = Task.Run(() =>
+        {
+            try
+            {
+                ExtractFiles(files, outputPath, completed);
+            }
+            finally
+            {
+                completed.CompleteAdding();
+            }
+        });
+
+        var done = new bool[files.Count];
+        var next = 0;
+        foreach (var index in completed.GetConsumingEnumerable())
         {
-            ProgressUpdate(file.Name, currentSize, totalSize);
-            currentSize += (long)file.Size();
+            done[index] = true;
+            while (next < files.Count && done[next])
+            {
+                ProgressUpdate(files[next].Name, currentSize, totalSize);
+                currentSize += (long)files[next].Size();
+                next++;
+            }
+        }
 
+        extraction.GetAwaiter().GetResult();
+    }
+
+    internal static void CreateOutputDirectories(List<PackagedFileInfo> files, string outputPath)
+    {
+        var directories = new HashSet<string>();
+        foreach (var file in files)
+        {
             if (file.IsDeletion()) continue;
 
             string outPath = Path.Join(outputPath, file.Name);
+            if (directories.Add(Path.GetDirectoryName(outPath)))
+            {
+                FileManager.TryToCreateDirectory(outPath);
+            }
+        }
+    }
+
+    private void ExtractFiles(List<PackagedFileInfo> files, string outputPath, BlockingCollection<int> completed)
+    {
+        var options = new ParallelOptions
+        {
+            MaxDegreeOfParallelism = MaxParallelism > 0 ? MaxParallelism : Environment.ProcessorCount
+        };
 
-            FileManager.TryToCreateDirectory(outPath);
+        // Hand out files one at a time in package order so progress doesn't stall behind a large range
+        var indices = Partitioner.Create(Enumerable.Range(0, files.Count), EnumerablePartitionerOptions.NoBuffering);
 
+        try
+        {
+            Parallel.ForEach(indices, options, index =>
+            {
+                ExtractFile(files[index], outputPath);
+                completed.Add(index);
+            });
+        }
+        catch (AggregateException e) when (e.InnerExceptions.Count == 1)
+        {
+            ExceptionDispatchInfo.Capture(e.InnerException).Throw();
+        }
+    }
+
+    private void ExtractFile(PackagedFileInfo file, string outputPath)
+    {
+        if (file.IsDeletion()) return;
+
+        string outPath = Path.Join(outputPath, file.Name);
+
+        if (ConvertPhysics && file.Name.EndsWith(".bin", StringComparison.OrdinalIgnoreCase))
+        {
+            ExtractPhysicsResource(file, outPath);
+            return;
+        }
+
+        using var outFile = File.Open(outPath, FileMode.Create, FileAccess.Write);
+        CopyContents(file, outFile);
+    }
+
+    internal static void CopyContents(PackagedFileInfo file, Stream outStream)
+    {
+        if (file.Solid)
+        {
+            outStream.Write(file.SolidContents().Span);
+            return;
+        }
+
+        var buffer = ArrayPool<byte>.Shared.Rent((int)Math.Min(file.Size(), (ulong)CopyBufferSize));
+
+        try
+        {
             using var inStream = file.CreateContentReader();
-            using var outFile = File.Open(outPath, FileMode.Create, FileAccess.Write);
-            inStream.CopyTo(outFile);
+            int read;
+            while ((read = inStream.Read(buffer, 0, buffer.Length)) > 0)
+            {
+                outStream.Write(buffer, 0, read);
+            }
+        }
+        finally
+        {
+            ArrayPool<byte>.Shared.Return(buffer);
+        }
+    }
+
+    internal static void ExtractPhysicsResource(PackagedFileInfo file, string outPath)
+    {
+        var contents = new byte[file.Size()];
+        using (var outStream = new MemoryStream(contents))
+        {
+            CopyContents(file, outStream);
+        }
+
+        if (PhysicsConversion.IsBinaryCollection(contents))
+        {
+            contents = PhysicsConversion.ToXml(contents);
+            outPath = Path.ChangeExtension(outPath, ".xml");
+        }
+
+        File.WriteAllBytes(outPath, contents);
+    }
+
+    private static void ConvertPhysicsResources(PackageBuildData build)
+    {
+        for (var i = 0; i < build.Files.Count; i++)
+        {
+            var file = build.Files[i];
+            if (!file.Path.EndsWith(".xml", StringComparison.OrdinalIgnoreCase)
+                || !PhysicsConversion.IsXmlCollection(file))
+            {
+                continue;
+            }
+
+            byte[] xml;
+            using (var stream = file.MakeInputStream())
+            using (var ms = new MemoryStream())
+            {
+                stream.CopyTo(ms);
+                xml = ms.ToArray();
+            }
+
+            build.Files[i] = PackageBuildInputFile.CreateFromBlob(PhysicsConversion.ToBinary(xml), Path.ChangeExtension(file.Path, ".bin"));
         }
     }
 
@@ -213,9 +408,82 @@ public class Packager
         ProgressUpdate("Enumerating files ...", 0, 1);
         AddFilesFromPath(build, inputPath);
 
+        if (ConvertPhysics)
+        {
+            ProgressUpdate("Converting physics resources ...", 0, 1);
+            ConvertPhysicsResources(build);
+        }
+
         ProgressUpdate("Creating archive ...", 0, 1);
+        if (Incremental && File.Exists(packagePath))
+        {
+            CreatePackageIncremental(packagePath, build);
+        }
+        else
+        {
+            WritePackage(packagePath, build);
+        }
+    }
+
+    private void WritePackage(string packagePath, PackageBuildData build)
+    {
         using var writer = PackageWriterFactory.Create(build, packagePath);
         writer.WriteProgress += WriteProgressUpdate;
         writer.Write();
+        WriteStats = writer.Stats;
+    }
+
+    private void CreatePackageIncremental(string packagePath, PackageBuildData build)
+    {
+        // The previous package stays mapped while building, so the new one is written
+        // next to it and moved into place afterwards
+        var tempPath = Path.Join(Path.GetDirectoryName(packagePath),
+            Path.GetFileNameWithoutExtension(packagePath) + ".tmp" + Path.GetExtension(packagePath));
+
+        Package previous;
+        try
+        {
+            previous = new PackageReader().Read(packagePath);
+        }
+        catch (Exception e) when (e is NotAPackageException || e is InvalidDataException)
+        {
+            // Nothing to reuse; do a full build
+            WritePackage(packagePath, build);
+            return;
+        }
+
+        try
+        {
+            using (previous)
+            {
+                build.PreviousPackage = previous;
+                WritePackage(tempPath, build);
+                build.PreviousPackage = null;
+            }
+
+            File.Move(tempPath, packagePath, true);
+            var part = 1;
+            for (; File.Exists(Package.MakePartFilename(tempPath, part)); part++)
+            {
+                File.Move(Package.MakePartFilename(tempPath, part), Package.MakePartFilename(packagePath, part), true);
+            }
+
+            // Remove parts left over from a previous build that had more of them
+            for (; File.Exists(Package.MakePartFilename(packagePath, part)); part++)
+            {
+                File.Delete(Package.MakePartFilename(packagePath, part));
+            }
+        }
+        catch (Exception)
+        {
+            build.PreviousPackage = null;
+            File.Delete(tempPath);
+            for (var part = 1; File.Exists(Package.MakePartFilename(tempPath, part)); part++)
+            {
+                File.Delete(Package.MakePartFilename(tempPath, part));
+            }
+
+            throw;
+        }
     }
 }
@@ -0,0 +1,200 @@
+﻿using System.Buffers;
+using System.Collections.Concurrent;
+using System.Diagnostics;
+using System.Runtime.ExceptionServices;
+using LSLib.LS.Enums;
+
+namespace LSLib.LS;
+
+public class PackageFileChange
+{
+    public PackagedFileInfo OldFile;
+    public PackagedFileInfo NewFile;
+    public string Reason;
+}
+
+public class PackageComparisonResult
+{
+    public List<PackagedFileInfo> Added = [];
+    public List<PackagedFileInfo> Removed = [];
+    public List<PackageFileChange> Changed = [];
+    // Number of files present in both packages
+    public int NumCompared;
+    // Number of files whose metadata wasn't conclusive and were compared byte by byte
+    public int NumContentCompared;
+    public TimeSpan Elapsed;
+}
+
+// Compares the file tables of two packages. Most files are decided from the file table alone (size, flags
+// and CRC); only files whose metadata can't tell whether they changed are read. Of those, files stored
+// with the same compression are compared in their stored form first, so decompression is only needed if
+// the file isn't byte-identical on disk or the package doesn't allow direct access (solid packages).
+public class PackageComparer
+{
+    // Number of files compared concurrently; 0 uses one worker per processor
+    public int MaxParallelism = 0;
+
+    private const int ReadBufferSize = 0x100000;
+
+    public PackageComparisonResult Compare(Package oldPackage, Package newPackage)
+    {
+        var timer = Stopwatch.StartNew();
+        var result = new PackageComparisonResult();
+
+        var oldFiles = new Dictionary<string, PackagedFileInfo>(StringComparer.OrdinalIgnoreCase);
+        foreach (var file in oldPackage.Files)
+        {
+            oldFiles[file.Name] = file;
+        }
+
+        var crcComparable = oldPackage.Version.HasCrc() && newPackage.Version.HasCrc();
+        List<(PackagedFileInfo Old, PackagedFileInfo New)> ambiguous = [];
+        foreach (var file in newPackage.Files)
+        {
+            if (!oldFiles.Remove(file.Name, out var oldFile))
+            {
+                result.Added.Add(file);
+                continue;
+            }
+
+            result.NumCompared++;
+            var reason = CompareMetadata(oldFile, file, crcComparable, out var conclusive);
+            if (reason != null)
+            {
+                result.Changed.Add(new PackageFileChange { OldFile = oldFile, NewFile = file, Reason = reason });
+            }
+            else if (!conclusive)
+            {
+                ambiguous.Add((oldFile, file));
+            }
+        }
+
+        result.Removed.AddRange(oldFiles.Values);
+
+        var changes = new ConcurrentBag<PackageFileChange>();
+        var options = new ParallelOptions
+        {
+            MaxDegreeOfParallelism = MaxParallelism > 0 ? MaxParallelism : Environment.ProcessorCount
+        };
+
+        try
+        {
+            Parallel.ForEach(ambiguous, options, pair =>
+            {
+                var reason = CompareContents(pair.Old, pair.New);
+                if (reason != null)
+                {
+                    changes.Add(new PackageFileChange { OldFile = pair.Old, NewFile = pair.New, Reason = reason });
+                }
+            });
+        }
+        catch (AggregateException e) when (e.InnerExceptions.Count == 1)
+        {
+            ExceptionDispatchInfo.Capture(e.InnerException).Throw();
+        }
+
+        result.Changed.AddRange(changes);
+        result.NumContentCompared = ambiguous.Count;
+
+        result.Added.Sort((a, b) => StringComparer.Ordinal.Compare(a.Name, b.Name));
+        result.Removed.Sort((a, b) => StringComparer.Ordinal.Compare(a.Name, b.Name));
+        result.Changed.Sort((a, b) => StringComparer.Ordinal.Compare(a.NewFile.Name, b.NewFile.Name));
+
+        timer.Stop();
+        result.Elapsed = timer.Elapsed;
+        return result;
+    }
+
+    // Returns why the file changed, or null if the file table doesn't show a difference.
+    // If the metadata isn't enough to tell that the contents are the same, conclusive is set to false.
+    private static string CompareMetadata(PackagedFileInfo oldFile, PackagedFileInfo newFile, bool crcComparable, out bool conclusive)
+    {
+        conclusive = true;
+
+        if (oldFile.IsDeletion() != newFile.IsDeletion())
+        {
+            return newFile.IsDeletion() ? "replaced by deletion marker" : "deletion marker replaced by file";
+        }
+
+        if (newFile.IsDeletion()) return null;
+
+        if (oldFile.Size() != newFile.Size())
+        {
+            return $"size {oldFile.Size()} -> {newFile.Size()}";
+        }
+
+        // CRCs are calculated over the stored data, so they're only comparable if the files
+        // were stored the same way. A zero CRC means that it wasn't filled in.
+        if (crcComparable && oldFile.Crc != 0 && newFile.Crc != 0
+            && oldFile.Flags == newFile.Flags && !oldFile.Solid && !newFile.Solid)
+        {
+            if (oldFile.Crc != newFile.Crc)
+            {
+                return $"CRC {oldFile.Crc:X8} -> {newFile.Crc:X8}";
+            }
+
+            return null;
+        }
+
+        conclusive = false;
+        return null;
+    }
+
+    private static string CompareContents(PackagedFileInfo oldFile, PackagedFileInfo newFile)
+    {
+        try
+        {
+            // Identical stored data means identical contents, without decompressing either file
+            if (!oldFile.Solid && !newFile.Solid
+                && oldFile.Flags == newFile.Flags
+                && oldFile.SizeOnDisk == newFile.SizeOnDisk
+                && StoredData(oldFile).SequenceEqual(StoredData(newFile)))
+            {
+                return null;
+            }
+
+            if (oldFile.HasDirectContents && newFile.HasDirectContents)
+            {
+                return oldFile.GetContentSpan().SequenceEqual(newFile.GetContentSpan()) ? null : "contents differ";
+            }
+
+            return StreamsEqual(oldFile, newFile) ? null : "contents differ";
+        }
+        catch (Exception e)
+        {
+            return $"failed to compare contents: {e.Message}";
+        }
+    }
+
+    private static ReadOnlySpan<byte> StoredData(PackagedFileInfo file)
+    {
+        return file.PackageMapping.GetSpan((long)file.OffsetInFile, (int)file.SizeOnDisk);
+    }
+
+    private static bool StreamsEqual(PackagedFileInfo oldFile, PackagedFileInfo newFile)
+    {
+        var oldBuffer = ArrayPool<byte>.Shared.Rent(ReadBufferSize);
+        var newBuffer = ArrayPool<byte>.Shared.Rent(ReadBufferSize);
+        try
+        {
+            using var oldStream = oldFile.CreateContentReader();
+            using var newStream = newFile.CreateContentReader();
+            while (true)
+            {
+                var oldRead = oldStream.ReadAtLeast(oldBuffer.AsSpan(0, ReadBufferSize), ReadBufferSize, false);
+                var newRead = newStream.ReadAtLeast(newBuffer.AsSpan(0, ReadBufferSize), ReadBufferSize, false);
+                if (oldRead != newRead || !oldBuffer.AsSpan(0, oldRead).SequenceEqual(newBuffer.AsSpan(0, newRead)))
+                {
+                    return false;
+                }
+
+                if (oldRead < ReadBufferSize) return true;
+            }
+        }
+        finally
+        {
+            ArrayPool<byte>.Shared.Return(oldBuffer);
+            ArrayPool<byte>.Shared.Return(newBuffer);
+        }
+    }
+}
@@ -1,4 +1,7 @@
-﻿using LSLib.LS.Enums;
+﻿using K4os.Compression.LZ4;
+using LSLib.LS.Enums;
+using Microsoft.Win32.SafeHandles;
+using System.Buffers;
 using System.IO.MemoryMappedFiles;
 
 namespace LSLib.LS;
@@ -18,6 +21,101 @@ public class NotAPackageException : Exception
     }
 }
 
+// Pointer into a memory-mapped archive part that stays acquired while the package is open,
+// so file contents can be sliced without creating a new view (and mapping) for every file.
+internal sealed unsafe class MappedPart : IDisposable
+{
+    private readonly MemoryMappedViewAccessor View;
+    private readonly byte* Base;
+    private readonly long Length;
+    private bool Disposed;
+
+    public MappedPart(MemoryMappedViewAccessor view)
+    {
+        View = view;
+        Length = view.Capacity;
+
+        byte* ptr = null;
+        view.SafeMemoryMappedViewHandle.AcquirePointer(ref ptr);
+        Base = ptr + view.PointerOffset;
+    }
+
+    public void Dispose()
+    {
+        if (!Disposed)
+        {
+            Disposed = true;
+            View.SafeMemoryMappedViewHandle.ReleasePointer();
+        }
+    }
+
+    public byte* GetPointer(long offset, long size)
+    {
+        ObjectDisposedException.ThrowIf(Disposed, this);
+
+        if (offset < 0 || size < 0 || offset + size > Length)
+        {
+            throw new InvalidDataException($"Data range {offset}+{size} is outside of the archive part");
+        }
+
+        return Base + offset;
+    }
+
+    public ReadOnlySpan<byte> GetSpan(long offset, int size)
+    {
+        return new ReadOnlySpan<byte>(GetPointer(offset, size), size);
+    }
+
+    public ReadOnlyMemory<byte> GetMemory(long offset, int size)
+    {
+        return new MappedMemory(GetPointer(offset, size), size).Memory;
+    }
+
+    public UnmanagedMemoryStream CreateStream(long offset, long size)
+    {
+        return new MappedStream(View.SafeMemoryMappedViewHandle, GetPointer(offset, size), size);
+    }
+}
+
+// Stream over a slice of a mapped archive part. Holds a reference on the view, so the mapping
+// stays valid until the stream is closed even if the package is disposed first.
+internal sealed unsafe class MappedStream : UnmanagedMemoryStream
+{
+    private SafeMemoryMappedViewHandle Handle;
+
+    public MappedStream(SafeMemoryMappedViewHandle handle, byte* pointer, long length)
+    {
+        bool added = false;
+        handle.DangerousAddRef(ref added);
+        Handle = handle;
+        Initialize(pointer, length, length, FileAccess.Read);
+    }
+
+    protected override void Dispose(bool disposing)
+    {
+        base.Dispose(disposing);
+        Interlocked.Exchange(ref Handle, null)?.DangerousRelease();
+    }
+}
+
+// Exposes a slice of a mapped archive part as Memory<byte>. The memory is owned by the package.
+internal sealed unsafe class MappedMemory : MemoryManager<byte>
+{
+    private readonly byte* Pointer;
+    private readonly int Length;
+
+    public MappedMemory(byte* pointer, int length)
+    {
+        Pointer = pointer;
+        Length = length;
+    }
+
+    public override Span<byte> GetSpan() => new(Pointer, Length);
+    public override MemoryHandle Pin(int elementIndex = 0) => new(Pointer + elementIndex);
+    public override void Unpin() { }
+    protected override void Dispose(bool disposing) { }
+}
+
 public class Package : IDisposable
 {
     public readonly string PackagePath;
@@ -26,9 +124,25 @@ public class Package : IDisposable
 
     internal MemoryMappedFile[] Parts;
     internal MemoryMappedViewAccessor[] Views;
+    internal MappedPart[] MappedParts;
 
     public PackageHeaderCommon Metadata;
-    public List<PackagedFileInfo> Files = [];
+
+    // File entries are only converted to PackagedFileInfo objects when the list is first accessed
+    private Lazy<List<PackagedFileInfo>> LazyFiles = new([]);
+    // Pooled buffer holding the decompressed file list until the table is built; returned on dispose otherwise
+    internal byte[] PooledFileList;
+
+    public List<PackagedFileInfo> Files
+    {
+        get { return LazyFiles.Value; }
+        set { LazyFiles = new(value); }
+    }
+
+    internal void SetFileTable(Func<List<PackagedFileInfo>> materialize)
+    {
+        LazyFiles = new(materialize, LazyThreadSafetyMode.ExecutionAndPublication);
+    }
     
     public PackageVersion Version
     {
@@ -56,6 +170,12 @@ public class Package : IDisposable
             string partPath = Package.MakePartFilename(PackagePath, part);
             OpenPart(part, partPath);
         }
+
+        MappedParts = new MappedPart[numParts];
+        for (var part = 0; part < numParts; part++)
+        {
+            MappedParts[part] = new MappedPart(Views[part]);
+        }
     }
 
     internal Package(string path)
@@ -68,6 +188,19 @@ public class Package : IDisposable
 
     public void Dispose()
     {
+        foreach (var part in MappedParts ?? [])
+        {
+            part?.Dispose();
+        }
+
+        MappedParts = null;
+
+        var fileList = Interlocked.Exchange(ref PooledFileList, null);
+        if (fileList != null)
+        {
+            ArrayPool<byte>.Shared.Return(fileList);
+        }
+
         MetadataView?.Dispose();
         MetadataFile?.Dispose();
 
@@ -91,66 +224,120 @@ public class Package : IDisposable
     }
 }
 
+// Contents of a solid archive. The frame is only decompressed when the first file is read from it.
+// The decompressed buffer is never modified, so any number of readers can slice it concurrently.
+public class SolidSegment
+{
+    private readonly Lazy<byte[]> Decompressed;
+    // Location of the compressed frame in archive part 0
+    public readonly long Offset;
+    public readonly int Size;
+
+    public SolidSegment(MemoryMappedViewAccessor view, long offset, int size)
+    {
+        Offset = offset;
+        Size = size;
+        Decompressed = new Lazy<byte[]>(() =>
+        {
+            byte[] frame = new byte[size];
+            view.ReadArray(offset, frame, 0, size);
+            return Native.LZ4FrameCompressor.Decompress(frame);
+        }, LazyThreadSafetyMode.ExecutionAndPublication);
+    }
+
+    public byte[] Contents => Decompressed.Value;
+}
+
 public class PackageReader
 {
     private bool MetadataOnly;
     private Package Pak;
 
-    private void ReadCompressedFileList<TFile>(MemoryMappedViewAccessor view, long offset)
-        where TFile : struct, ILSPKFile
+    private Func<List<PackagedFileInfo>> ReadCompressedFileList<TFile>(MemoryMappedViewAccessor view, long offset, out int numFiles)
+        where TFile : unmanaged, ILSPKFile
     {
-        int numFiles = view.ReadInt32(offset);
-        byte[] compressed;
+        var mapping = Pak.MappedParts[0];
+        numFiles = view.ReadInt32(offset);
+        ReadOnlySpan<byte> compressed;
         if (Pak.Metadata.Version > 13)
         {
             int compressedSize = view.ReadInt32(offset + 4);
-            compressed = new byte[compressedSize];
-            view.ReadArray(offset + 8, compressed, 0, compressedSize);
+            compressed = mapping.GetSpan(offset + 8, compressedSize);
         }
         else
         {
-            compressed = new byte[(int)Pak.Metadata.FileListSize - 4];
-            view.ReadArray(offset + 4, compressed, 0, (int)Pak.Metadata.FileListSize - 4);
+            compressed = mapping.GetSpan(offset + 4, (int)Pak.Metadata.FileListSize - 4);
         }
 
-        int fileBufferSize = Marshal.SizeOf(typeof(TFile)) * numFiles;
-        var fileBuf = CompressionHelpers.Decompress(compressed, fileBufferSize, CompressionFlags.MethodLZ4);
-
-        using var ms = new MemoryStream(fileBuf);
-        using var msr = new BinaryReader(ms);
-
-        var entries = new TFile[numFiles];
-        BinUtils.ReadStructsBlitted(msr, entries);
-
-        foreach (var entry in entries)
+        // Decompress straight from the mapping into a pooled buffer; the entries are read from it in place
+        int fileBufferSize = checked(Marshal.SizeOf<TFile>() * numFiles);
+        var fileBuf = ArrayPool<byte>.Shared.Rent(fileBufferSize);
+        if (LZ4Codec.Decode(compressed, fileBuf.AsSpan(0, fileBufferSize)) != fileBufferSize)
         {
-            Pak.Files.Add(PackagedFileInfo.CreateFromEntry(Pak, entry, Pak.Parts[entry.ArchivePartNumber()], Pak.Views[entry.ArchivePartNumber()]));
+            ArrayPool<byte>.Shared.Return(fileBuf);
+            throw new InvalidDataException("Failed to decompress package file list");
         }
+
+        var pak = Pak;
+        pak.PooledFileList = fileBuf;
+        return () =>
+        {
+            // Take ownership of the buffer, so Dispose() doesn't return it a second time
+            var buf = Interlocked.Exchange(ref pak.PooledFileList, null);
+            ObjectDisposedException.ThrowIf(buf == null, pak);
+            try
+            {
+                var entries = MemoryMarshal.Cast<byte, TFile>(buf.AsSpan(0, fileBufferSize));
+                var files = new List<PackagedFileInfo>(entries.Length);
+                foreach (ref readonly var entry in entries)
+                {
+                    files.Add(PackagedFileInfo.CreateFromEntry(pak, entry, entry.ArchivePartNumber()));
+                }
+
+                return files;
+            }
+            finally
+            {
+                ArrayPool<byte>.Shared.Return(buf);
+            }
+        };
     }
 
-    private void ReadFileList<TFile>(MemoryMappedViewAccessor view, long offset) 
-        where TFile : struct, ILSPKFile
+    private Func<List<PackagedFileInfo>> ReadFileList<TFile>(MemoryMappedViewAccessor view, long offset, out int numFiles)
+        where TFile : unmanaged, ILSPKFile
     {
-        var entries = new TFile[Pak.Metadata.NumFiles];
-        BinUtils.ReadStructs(view, offset, entries);
-
-        foreach (var entry in entries)
+        var pak = Pak;
+        var mapping = pak.MappedParts[0];
+        numFiles = (int)pak.Metadata.NumFiles;
+        var tableSize = checked(Marshal.SizeOf<TFile>() * numFiles);
+        // Check bounds now, so a truncated package fails to open rather than on first use
+        mapping.GetPointer(offset, tableSize);
+
+        // The table stays mapped while the package is open, so entries are read directly from the view
+        return () =>
         {
-            var file = PackagedFileInfo.CreateFromEntry(Pak, entry, Pak.Parts[entry.ArchivePartNumber()], Pak.Views[entry.ArchivePartNumber()]);
-            if (file.ArchivePart == 0)
+            var entries = MemoryMarshal.Cast<byte, TFile>(mapping.GetSpan(offset, tableSize));
+            var files = new List<PackagedFileInfo>(entries.Length);
+            foreach (ref readonly var entry in entries)
             {
-                file.OffsetInFile += Pak.Metadata.DataOffset;
+                var file = PackagedFileInfo.CreateFromEntry(pak, entry, entry.ArchivePartNumber());
+                if (file.ArchivePart == 0)
+                {
+                    file.OffsetInFile += pak.Metadata.DataOffset;
+                }
+
+                files.Add(file);
             }
 
-            Pak.Files.Add(file);
-        }
+            return files;
+        };
     }
 
     private Package ReadHeaderAndFileList<THeader, TFile>(MemoryMappedViewAccessor view, long offset)
-        where THeader : struct, ILSPKHeader 
-        where TFile : struct, ILSPKFile
+        where THeader : unmanaged, ILSPKHeader 
+        where TFile : unmanaged, ILSPKFile
     {
-        view.Read<THeader>(offset, out var header);
+        BinUtils.ReadStruct(view, offset, out THeader header);
 
         Pak.Metadata = header.ToCommonHeader();
 
@@ -158,25 +345,36 @@ public class PackageReader
 
         Pak.OpenStreams((int)Pak.Metadata.NumParts);
 
+        Func<List<PackagedFileInfo>> readFiles;
+        int numFiles;
         if (Pak.Metadata.Version > 10)
         {
             Pak.Metadata.DataOffset = (uint)(offset + Marshal.SizeOf<THeader>());
-            ReadCompressedFileList<TFile>(view, (long)Pak.Metadata.FileListOffset);
+            readFiles = ReadCompressedFileList<TFile>(view, (long)Pak.Metadata.FileListOffset, out numFiles);
         }
         else
         {
-            ReadFileList<TFile>(view, offset + Marshal.SizeOf<THeader>());
+            readFiles = ReadFileList<TFile>(view, offset + Marshal.SizeOf<THeader>(), out numFiles);
         }
 
-        if (Pak.Metadata.Flags.HasFlag(PackageFlags.Solid) && Pak.Files.Count > 0)
+        if (Pak.Metadata.Flags.HasFlag(PackageFlags.Solid) && numFiles > 0)
         {
-            UnpackSolidSegment(view);
+            // Locating the solid frame needs every entry, so it's done when the table is built
+            var pak = Pak;
+            var readEntries = readFiles;
+            readFiles = () =>
+            {
+                var files = readEntries();
+                UnpackSolidSegment(pak, view, files);
+                return files;
+            };
         }
 
+        Pak.SetFileTable(readFiles);
         return Pak;
     }
 
-    private void UnpackSolidSegment(MemoryMappedViewAccessor view)
+    private static void UnpackSolidSegment(Package pak, MemoryMappedViewAccessor view, List<PackagedFileInfo> files)
     {
         // Calculate compressed frame offset and bounds
         ulong totalUncompressedSize = 0;
@@ -184,7 +382,7 @@ public class PackageReader
         ulong firstOffset = 0xffffffff;
         ulong lastOffset = 0;
 
-        foreach (var entry in Pak.Files)
+        foreach (var entry in files)
         {
             var file = entry as PackagedFileInfo;
 
@@ -200,23 +398,19 @@ public class PackageReader
             }
         }
 
-        if (firstOffset != Pak.Metadata.DataOffset + 7 || lastOffset - firstOffset != totalSizeOnDisk)
+        if (firstOffset != pak.Metadata.DataOffset + 7 || lastOffset - firstOffset != totalSizeOnDisk)
         {
             string msg = $"Incorrectly compressed solid archive; offsets {firstOffset}/{lastOffset}, bytes {totalSizeOnDisk}";
             throw new InvalidDataException(msg);
         }
 
-        // Decompress all files as a single frame (solid)
-        byte[] frame = new byte[lastOffset - Pak.Metadata.DataOffset];
-        view.ReadArray(Pak.Metadata.DataOffset, frame, 0, (int)(lastOffset - Pak.Metadata.DataOffset));
-
-        byte[] decompressed = Native.LZ4FrameCompressor.Decompress(frame);
-        var decompressedStream = new MemoryStream(decompressed);
+        // All files are compressed as a single frame (solid); defer decompression until it's needed
+        var segment = new SolidSegment(view, pak.Metadata.DataOffset, (int)(lastOffset - pak.Metadata.DataOffset));
 
         // Update offsets to point to the decompressed chunk
-        ulong offset = Pak.Metadata.DataOffset + 7;
+        ulong offset = pak.Metadata.DataOffset + 7;
         ulong compressedOffset = 0;
-        foreach (var entry in Pak.Files)
+        foreach (var entry in files)
         {
             var file = entry as PackagedFileInfo;
 
@@ -225,7 +419,7 @@ public class PackageReader
                 throw new InvalidDataException("File list in solid archive not contiguous");
             }
 
-            file.MakeSolid(compressedOffset, decompressedStream);
+            file.MakeSolid(compressedOffset, segment);
 
             offset += file.SizeOnDisk;
             compressedOffset += file.UncompressedSize;
@@ -0,0 +1,129 @@
+﻿using System.Buffers;
+using System.Collections.Concurrent;
+using System.Diagnostics;
+using LSLib.LS.Enums;
+
+namespace LSLib.LS;
+
+public class PackageVerificationError
+{
+    public PackagedFileInfo File;
+    public string Message;
+}
+
+public class PackageVerificationResult
+{
+    public int NumFiles;
+    public long CompressedBytes;
+    public long UncompressedBytes;
+    public TimeSpan Elapsed;
+    public List<PackageVerificationError> Errors = [];
+
+    public double GigabytesPerSecond => Elapsed.TotalSeconds > 0 ? CompressedBytes / Elapsed.TotalSeconds / 1e9 : 0.0;
+}
+
+// Checks the CRC and decompressibility of every file in a package without extracting anything.
+public class PackageVerifier
+{
+    // Number of files verified concurrently; 0 uses one worker per processor
+    public int MaxParallelism = 0;
+
+    private const int ReadBufferSize = 0x100000;
+
+    public PackageVerificationResult Verify(Package package)
+    {
+        var files = package.Files.Where(f => !f.IsDeletion()).ToList();
+        // Only v10 - v16 packages store CRCs; newer ones leave the field zeroed
+        var hasCrc = package.Version.HasCrc();
+
+        var errors = new ConcurrentBag<PackageVerificationError>();
+        var options = new ParallelOptions
+        {
+            MaxDegreeOfParallelism = MaxParallelism > 0 ? MaxParallelism : Environment.ProcessorCount
+        };
+
+        var timer = Stopwatch.StartNew();
+        Parallel.ForEach(files, options, file =>
+        {
+            var error = VerifyFile(file, hasCrc);
+            if (error != null)
+            {
+                errors.Add(new PackageVerificationError { File = file, Message = error });
+            }
+        });
+        timer.Stop();
+
+        return new PackageVerificationResult
+        {
+            NumFiles = files.Count,
+            CompressedBytes = files.Sum(f => (long)f.SizeOnDisk),
+            UncompressedBytes = files.Sum(f => (long)f.Size()),
+            Elapsed = timer.Elapsed,
+            Errors = [.. errors.OrderBy(e => e.File.Name, StringComparer.Ordinal)]
+        };
+    }
+
+    private static string VerifyFile(PackagedFileInfo file, bool hasCrc)
+    {
+        try
+        {
+            if (file.OffsetInFile + file.SizeOnDisk > (ulong)file.PackageView.Capacity)
+            {
+                return $"Data range {file.OffsetInFile}+{file.SizeOnDisk} is outside of archive part {file.ArchivePart}";
+            }
+
+            if (hasCrc)
+            {
+                var crc = ComputeCrc(file);
+                if (crc != file.Crc)
+                {
+                    return $"CRC mismatch; expected {file.Crc:X8}, got {crc:X8}";
+                }
+            }
+
+            var size = ReadContents(file);
+            if (size != file.Size())
+            {
+                return $"Decompressed size mismatch; expected {file.Size()}, got {size}";
+            }
+
+            return null;
+        }
+        catch (Exception e)
+        {
+            return $"Failed to decompress: {e.Message}";
+        }
+    }
+
+    private static unsafe UInt32 ComputeCrc(PackagedFileInfo file)
+    {
+        var data = file.PackageMapping.GetPointer((long)file.OffsetInFile, (long)file.SizeOnDisk);
+        return Native.Crc32.Compute((IntPtr)data, (long)file.SizeOnDisk);
+    }
+
+    private static ulong ReadContents(PackagedFileInfo file)
+    {
+        if (file.Solid)
+        {
+            return (ulong)file.SolidContents().Length;
+        }
+
+        var buffer = ArrayPool<byte>.Shared.Rent(ReadBufferSize);
+        try
+        {
+            using var inStream = file.CreateContentReader();
+            ulong total = 0;
+            int read;
+            while ((read = inStream.Read(buffer, 0, buffer.Length)) > 0)
+            {
+                total += (ulong)read;
+            }
+
+            return total;
+        }
+        finally
+        {
+            ArrayPool<byte>.Shared.Return(buffer);
+        }
+    }
+}
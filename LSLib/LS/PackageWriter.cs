@@ -1,6 +1,9 @@
-﻿using System.IO;
+﻿using System.Buffers;
+using System.Collections.Concurrent;
+using System.IO;
 using System.IO.Hashing;
 using System.Security.Cryptography;
+using K4os.Compression.LZ4;
 using LSLib.LS.Enums;
 
 namespace LSLib.LS;
@@ -9,6 +12,18 @@ public class PackageBuildTransientFile : PackagedFileInfoCommon
 {
 }
 
+public class PackageWriteStats
+{
+    // Files copied from the previous package without recompression
+    public int ReusedFiles;
+    public long ReusedBytes;
+    // Files sharing the body of an identical file written earlier, and the bytes saved by it
+    public int DeduplicatedFiles;
+    public long DeduplicatedBytes;
+    // Files of the previous package that couldn't be read back and were compressed again
+    public readonly ConcurrentQueue<string> ReuseErrors = new();
+}
+
 abstract public class PackageWriter : IDisposable
 {
     public delegate void WriteProgressDelegate(PackageBuildInputFile file, long numerator, long denominator);
@@ -19,6 +34,11 @@ abstract public class PackageWriter : IDisposable
     protected readonly string PackagePath;
     protected readonly Stream MainStream;
     public WriteProgressDelegate WriteProgress = delegate { };
+    public readonly PackageWriteStats Stats = new();
+    // Archive hash computed while reading the input files; null if it has to be computed afterwards
+    private MD5 StreamingHash;
+
+    private const int CompareBufferSize = 0x100000;
 
     public PackageWriter(PackageBuildData build, string packagePath)
     {
@@ -37,6 +57,8 @@ abstract public class PackageWriter : IDisposable
 
     public void Dispose()
     {
+        StreamingHash?.Dispose();
+
         foreach (Stream stream in Streams)
         {
             stream.Dispose();
@@ -78,23 +100,255 @@ abstract public class PackageWriter : IDisposable
         stream.Write(pad, 0, pad.Length);
     }
 
-    protected PackageBuildTransientFile WriteFile(PackageBuildInputFile input)
+    private class PendingFile
+    {
+        public PackageBuildInputFile Input;
+        public long InputSize;
+        public CompressionMethod Compression;
+        public LSCompressionLevel CompressionLevel;
+        public byte[] Uncompressed;
+        public ulong UncompressedSize;
+        public CompressionFlags Flags;
+        public UInt32 Crc;
+        public PackagedFileInfo Previous;
+        public PendingFile DuplicateOf;
+        public PackageBuildTransientFile Written;
+        public readonly TaskCompletionSource<byte[]> Compressed = new(TaskCreationOptions.RunContinuationsAsynchronously);
+    }
+
+    private void ReadInput(PendingFile pending, InFlightBudget budget, CancellationToken token)
+    {
+        using var inputStream = pending.Input.MakeInputStream();
+
+        pending.Compression = Build.Compression;
+        pending.CompressionLevel = Build.CompressionLevel;
+
+        if (!CanCompressFile(pending.Input, inputStream))
+        {
+            pending.Compression = CompressionMethod.None;
+            pending.CompressionLevel = LSCompressionLevel.Fast;
+        }
+
+        pending.InputSize = inputStream.Length;
+        budget.Acquire(pending.InputSize, token);
+
+        pending.Uncompressed = new byte[inputStream.Length];
+        inputStream.ReadExactly(pending.Uncompressed, 0, pending.Uncompressed.Length);
+    }
+
+    private Dictionary<string, PackagedFileInfo> IndexPreviousFiles()
+    {
+        var previous = Build.PreviousPackage;
+        var files = new Dictionary<string, PackagedFileInfo>();
+
+        // Solid packages compress all files into a single frame, so there's nothing to copy from;
+        // a different version would also need the entries to be re-encoded
+        if (previous == null
+            || previous.Version != Build.Version
+            || previous.Metadata.Flags.HasFlag(PackageFlags.Solid))
+        {
+            return files;
+        }
+
+        foreach (var file in previous.Files)
+        {
+            if (!file.IsDeletion())
+            {
+                files[file.Name] = file;
+            }
+        }
+
+        return files;
+    }
+
+    private void ReadFiles(BlockingCollection<PendingFile> compressQueue, BlockingCollection<PendingFile> writeQueue,
+        InFlightBudget budget, CancellationToken token)
+    {
+        try
+        {
+            var previousFiles = IndexPreviousFiles();
+            // Solid packages can't have multiple entries pointing at the same data
+            var contents = Build.Deduplicate && !Build.Flags.HasFlag(PackageFlags.Solid)
+                ? new Dictionary<(UInt128, long, CompressionFlags), PendingFile>()
+                : null;
+
+            foreach (var input in Build.Files)
+            {
+                var pending = new PendingFile { Input = input };
+                writeQueue.Add(pending, token);
+
+                try
+                {
+                    previousFiles.TryGetValue(input.Path.Replace('\\', '/'), out pending.Previous);
+                    ReadInput(pending, budget, token);
+                    StreamingHash?.TransformBlock(pending.Uncompressed, 0, pending.Uncompressed.Length, null, 0);
+
+                    if (contents != null && FindDuplicate(pending, contents, budget)) continue;
+                }
+                catch (Exception e) when (e is not OperationCanceledException)
+                {
+                    // Surfaced by the writer when it reaches this file
+                    pending.DuplicateOf = null;
+                    pending.Compressed.SetException(e);
+                    break;
+                }
+
+                compressQueue.Add(pending, token);
+            }
+        }
+        finally
+        {
+            compressQueue.CompleteAdding();
+            writeQueue.CompleteAdding();
+        }
+    }
+
+    private bool FindDuplicate(PendingFile pending, Dictionary<(UInt128, long, CompressionFlags), PendingFile> contents, InFlightBudget budget)
+    {
+        if (pending.InputSize == 0) return false;
+
+        var flags = CompressionHelpers.MakeCompressionFlags(pending.Compression, pending.CompressionLevel);
+        var key = (XxHash128.HashToUInt128(pending.Uncompressed), pending.InputSize, flags);
+        if (contents.TryAdd(key, pending)) return false;
+
+        // The body is written once by the first file; this one only needs an entry
+        pending.DuplicateOf = contents[key];
+        pending.Uncompressed = null;
+        budget.Release(pending.InputSize);
+        return true;
+    }
+
+    private bool MatchesCompression(PackagedFileInfo previous, PendingFile pending)
     {
-        using var inputStream = input.MakeInputStream();
+        if (previous.Flags.Method() != pending.Compression) return false;
+
+        // Uncompressed files and <= v10 packages don't store the compression level
+        return pending.Compression == CompressionMethod.None
+            || Build.Version <= PackageVersion.V10
+            || previous.Flags.Level() == pending.CompressionLevel;
+    }
 
-        var compression = Build.Compression;
-        var compressionLevel = Build.CompressionLevel;
+    private byte[] TryReusePrevious(PendingFile pending)
+    {
+        var previous = pending.Previous;
+        if (previous == null
+            || previous.Size() != (ulong)pending.Uncompressed.Length
+            || previous.SizeOnDisk > int.MaxValue
+            || !MatchesCompression(previous, pending))
+        {
+            return null;
+        }
 
-        if (!CanCompressFile(input, inputStream))
+        byte[] compressed;
+        try
+        {
+            // Decompressing is much cheaper than compressing again; make sure the contents are identical
+            var stored = previous.PackageMapping.GetSpan((long)previous.OffsetInFile, (int)previous.SizeOnDisk);
+            if (!StoredContentsEqual(previous, stored, pending.Uncompressed)) return null;
+            compressed = stored.ToArray();
+        }
+        catch (Exception e)
         {
-            compression = CompressionMethod.None;
-            compressionLevel = LSCompressionLevel.Fast;
+            // A damaged entry in the previous package only means the file has to be compressed again
+            Stats.ReuseErrors.Enqueue($"{previous.Name}: {e.Message}");
+            return null;
         }
 
-        var uncompressed = new byte[inputStream.Length];
-        inputStream.ReadExactly(uncompressed, 0, uncompressed.Length);
-        var compressed = CompressionHelpers.Compress(uncompressed, compression, compressionLevel);
+        pending.Flags = previous.Flags;
+        pending.Crc = previous.Crc;
+        Interlocked.Increment(ref Stats.ReusedFiles);
+        Interlocked.Add(ref Stats.ReusedBytes, compressed.Length);
+        return compressed;
+    }
+
+    private static bool StoredContentsEqual(PackagedFileInfo previous, ReadOnlySpan<byte> stored, byte[] expected)
+    {
+        switch (previous.Flags.Method())
+        {
+            case CompressionMethod.None:
+                return stored.SequenceEqual(expected);
+
+            case CompressionMethod.LZ4:
+                {
+                    // LZ4 blocks can't be decoded incrementally; decode into a pooled buffer instead of a new array
+                    var buffer = ArrayPool<byte>.Shared.Rent(expected.Length);
+                    try
+                    {
+                        var length = LZ4Codec.Decode(stored, buffer.AsSpan(0, expected.Length));
+                        if (length != expected.Length)
+                        {
+                            throw new InvalidDataException("Failed to decompress LZ4 stream");
+                        }
+
+                        return buffer.AsSpan(0, length).SequenceEqual(expected);
+                    }
+                    finally
+                    {
+                        ArrayPool<byte>.Shared.Return(buffer);
+                    }
+                }
+
+            default:
+                {
+                    using var contents = previous.CreateContentReader();
+                    return ContentsEqual(contents, expected);
+                }
+        }
+    }
 
+    private static bool ContentsEqual(Stream contents, byte[] expected)
+    {
+        var buffer = ArrayPool<byte>.Shared.Rent(CompareBufferSize);
+        try
+        {
+            var offset = 0;
+            int read;
+            while ((read = contents.Read(buffer, 0, buffer.Length)) > 0)
+            {
+                if (read > expected.Length - offset
+                    || !buffer.AsSpan(0, read).SequenceEqual(expected.AsSpan(offset, read)))
+                {
+                    return false;
+                }
+
+                offset += read;
+            }
+
+            return offset == expected.Length;
+        }
+        finally
+        {
+            ArrayPool<byte>.Shared.Return(buffer);
+        }
+    }
+
+    private void CompressFiles(BlockingCollection<PendingFile> compressQueue, CancellationToken token)
+    {
+        foreach (var pending in compressQueue.GetConsumingEnumerable(token))
+        {
+            try
+            {
+                var compressed = TryReusePrevious(pending);
+                if (compressed == null)
+                {
+                    compressed = CompressionHelpers.Compress(pending.Uncompressed, pending.Compression, pending.CompressionLevel);
+                    pending.Flags = CompressionHelpers.MakeCompressionFlags(pending.Compression, pending.CompressionLevel);
+                    pending.Crc = Build.Version.HasCrc() ? Crc32.HashToUInt32(compressed) : 0;
+                }
+
+                pending.UncompressedSize = (ulong)pending.Uncompressed.Length;
+                pending.Uncompressed = null;
+                pending.Compressed.SetResult(compressed);
+            }
+            catch (Exception e)
+            {
+                pending.Compressed.SetException(e);
+            }
+        }
+    }
+
+    private PackageBuildTransientFile WriteCompressed(PendingFile pending, byte[] compressed)
+    {
         if (Streams.Last().Position + compressed.Length > Build.Version.MaxPackageSize())
         {
             // Start a new package file if the current one is full.
@@ -106,31 +360,58 @@ abstract public class PackageWriter : IDisposable
         Stream stream = Streams.Last();
         var packaged = new PackageBuildTransientFile
         {
-            Name = input.Path.Replace('\\', '/'),
-            UncompressedSize = (ulong)uncompressed.Length,
+            Name = pending.Input.Path.Replace('\\', '/'),
+            UncompressedSize = pending.UncompressedSize,
             SizeOnDisk = (ulong)compressed.Length,
             ArchivePart = (UInt32)(Streams.Count - 1),
             OffsetInFile = (ulong)stream.Position,
-            Flags = CompressionHelpers.MakeCompressionFlags(compression, compressionLevel)
+            Flags = pending.Flags,
+            Crc = pending.Crc
         };
 
         stream.Write(compressed, 0, compressed.Length);
 
-        if (Build.Version.HasCrc())
+        if (!Build.Flags.HasFlag(PackageFlags.Solid))
         {
-            packaged.Crc = Crc32.HashToUInt32(compressed);
+            WritePadding(stream);
         }
-        else
+
+        pending.Written = packaged;
+        return packaged;
+    }
+
+    private PackageBuildTransientFile WriteDuplicate(PendingFile pending)
+    {
+        var original = pending.DuplicateOf.Written;
+        var packaged = new PackageBuildTransientFile
         {
-            packaged.Crc = 0;
-        }
+            Name = pending.Input.Path.Replace('\\', '/'),
+            UncompressedSize = original.UncompressedSize,
+            SizeOnDisk = original.SizeOnDisk,
+            ArchivePart = original.ArchivePart,
+            OffsetInFile = original.OffsetInFile,
+            Flags = original.Flags,
+            Crc = original.Crc
+        };
 
-        if (!Build.Flags.HasFlag(PackageFlags.Solid))
+        Stats.DeduplicatedFiles++;
+        Stats.DeduplicatedBytes += (long)original.SizeOnDisk;
+        return packaged;
+    }
+
+    protected virtual bool HasArchiveHash => true;
+
+    private bool CanStreamArchiveHash()
+    {
+        if (Build.Version >= PackageVersion.V15) return true;
+
+        // Older versions hash files in path order; this only matches the read order if the inputs are already sorted
+        for (var i = 1; i < Build.Files.Count; i++)
         {
-            WritePadding(stream);
+            if (String.CompareOrdinal(Build.Files[i - 1].Path, Build.Files[i].Path) > 0) return false;
         }
 
-        return packaged;
+        return true;
     }
 
     protected List<PackageBuildTransientFile> PackFiles()
@@ -138,22 +419,77 @@ abstract public class PackageWriter : IDisposable
         long totalSize = Build.Files.Sum(p => (long)p.Size());
         long currentSize = 0;
 
+        if (HasArchiveHash && CanStreamArchiveHash())
+        {
+            StreamingHash = MD5.Create();
+        }
+
+        // Files are read ahead on one thread, compressed on a pool of workers and written
+        // in their original order on the calling thread, which assigns offsets and parts
+        var numWorkers = Build.CompressionThreads > 0 ? Build.CompressionThreads : Environment.ProcessorCount;
+        var budget = new InFlightBudget(Build.MaxInFlightBytes);
+        using var cancellation = new CancellationTokenSource();
+        using var compressQueue = new BlockingCollection<PendingFile>();
+        using var writeQueue = new BlockingCollection<PendingFile>();
+
+        // The reader and workers spend most of their time blocked on the queues or the budget,
+        // so they get dedicated threads instead of pool threads
+        var readTask = Task.Factory.StartNew(() => ReadFiles(compressQueue, writeQueue, budget, cancellation.Token),
+            CancellationToken.None, TaskCreationOptions.LongRunning, TaskScheduler.Default);
+        var tasks = new List<Task> { readTask };
+
+        for (var i = 0; i < numWorkers; i++)
+        {
+            tasks.Add(Task.Factory.StartNew(() => CompressFiles(compressQueue, cancellation.Token),
+                CancellationToken.None, TaskCreationOptions.LongRunning, TaskScheduler.Default));
+        }
+
         var writtenFiles = new List<PackageBuildTransientFile>();
-        foreach (var file in Build.Files)
+        try
         {
-            WriteProgress(file, currentSize, totalSize);
-            writtenFiles.Add(WriteFile(file));
-            currentSize += file.Size();
+            foreach (var pending in writeQueue.GetConsumingEnumerable())
+            {
+                WriteProgress(pending.Input, currentSize, totalSize);
+                if (pending.DuplicateOf != null)
+                {
+                    writtenFiles.Add(WriteDuplicate(pending));
+                }
+                else
+                {
+                    var compressed = pending.Compressed.Task.GetAwaiter().GetResult();
+                    writtenFiles.Add(WriteCompressed(pending, compressed));
+                    budget.Release(pending.InputSize);
+                }
+
+                currentSize += pending.Input.Size();
+            }
+
+            // Failures that happen before a file is queued aren't attached to any pending file
+            readTask.GetAwaiter().GetResult();
+        }
+        finally
+        {
+            // Stop the reader and workers if writing failed; their errors are reported through the pending files
+            cancellation.Cancel();
+            try
+            {
+                Task.WaitAll([.. tasks]);
+            }
+            catch (AggregateException)
+            {
+            }
         }
 
         return writtenFiles;
     }
 
     internal void WriteFileList<TFile>(BinaryWriter metadataWriter, List<PackageBuildTransientFile> files)
-        where TFile : ILSPKFile
+        where TFile : unmanaged, ILSPKFile
     {
-        foreach (var file in files)
+        var entries = new TFile[files.Count];
+        for (var i = 0; i < files.Count; i++)
         {
+            var file = files[i];
             if (file.ArchivePart == 0)
             {
                 file.OffsetInFile -= Metadata.DataOffset;
@@ -162,27 +498,23 @@ abstract public class PackageWriter : IDisposable
             // <= v10 packages don't support compression level in the flags field
             file.Flags = (CompressionFlags)((byte)file.Flags & 0x0f);
 
-            var entry = (TFile)TFile.FromCommon(file);
-            BinUtils.WriteStruct(metadataWriter, ref entry);
+            entries[i] = (TFile)TFile.FromCommon(file);
         }
+
+        BinUtils.WriteStructs<TFile>(metadataWriter, entries.AsSpan());
     }
 
     internal void WriteCompressedFileList<TFile>(BinaryWriter metadataWriter, List<PackageBuildTransientFile> files)
-        where TFile : ILSPKFile
+        where TFile : unmanaged, ILSPKFile
     {
-        byte[] fileListBuf;
-        using (var fileList = new MemoryStream())
-        using (var fileListWriter = new BinaryWriter(fileList))
+        var entries = new TFile[files.Count];
+        for (var i = 0; i < files.Count; i++)
         {
-            foreach (var file in files)
-            {
-                var entry = (TFile)TFile.FromCommon(file);
-                BinUtils.WriteStruct(fileListWriter, ref entry);
-            }
-
-            fileListBuf = fileList.ToArray();
+            entries[i] = (TFile)TFile.FromCommon(files[i]);
         }
 
+        var fileListBuf = MemoryMarshal.AsBytes(entries.AsSpan()).ToArray();
+
         byte[] compressedFileList = CompressionHelpers.Compress(fileListBuf, CompressionMethod.LZ4, LSCompressionLevel.Default);
 
         metadataWriter.Write((UInt32)files.Count);
@@ -200,6 +532,28 @@ abstract public class PackageWriter : IDisposable
     }
 
     protected byte[] ComputeArchiveHash()
+    {
+        byte[] hash = StreamingHash != null ? FinishStreamingHash() : ReadArchiveHash();
+
+        // All hash bytes are incremented by 1
+        for (var i = 0; i < hash.Length; i++)
+        {
+            hash[i] += 1;
+        }
+
+        return hash;
+    }
+
+    private byte[] FinishStreamingHash()
+    {
+        StreamingHash.TransformFinalBlock(Array.Empty<byte>(), 0, 0);
+        var hash = StreamingHash.Hash;
+        StreamingHash.Dispose();
+        StreamingHash = null;
+        return hash;
+    }
+
+    private byte[] ReadArchiveHash()
     {
         // MD5 is computed over the contents of all files in an alphabetically sorted order
         var orderedFileList = Build.Files.Select(item => item).ToList();
@@ -219,24 +573,54 @@ abstract public class PackageWriter : IDisposable
         }
 
         md5.TransformFinalBlock(Array.Empty<byte>(), 0, 0);
-        byte[] hash = md5.Hash;
+        return md5.Hash;
+    }
 
-        // All hash bytes are incremented by 1
-        for (var i = 0; i < hash.Length; i++)
+    abstract public void Write();
+}
+
+
+// Limits the number of uncompressed bytes read ahead of the package writer.
+// A file larger than the whole budget is still admitted when nothing else is in flight.
+internal class InFlightBudget(long limit)
+{
+    private readonly long Limit = limit;
+    private readonly object Lock = new();
+    private long Used = 0;
+
+    public void Acquire(long bytes, CancellationToken token)
+    {
+        using var registration = token.Register(() =>
         {
-            hash[i] += 1;
-        }
+            lock (Lock) Monitor.PulseAll(Lock);
+        });
 
-        return hash;
+        lock (Lock)
+        {
+            while (Used > 0 && Used + bytes > Limit)
+            {
+                token.ThrowIfCancellationRequested();
+                Monitor.Wait(Lock);
+            }
+
+            Used += bytes;
+        }
     }
 
-    abstract public void Write();
+    public void Release(long bytes)
+    {
+        lock (Lock)
+        {
+            Used -= bytes;
+            Monitor.PulseAll(Lock);
+        }
+    }
 }
 
 
 internal class PackageWriter_V7<THeader, TFile> : PackageWriter
-    where THeader : ILSPKHeader
-    where TFile : ILSPKFile
+    where THeader : unmanaged, ILSPKHeader
+    where TFile : unmanaged, ILSPKFile
 {
     public PackageWriter_V7(PackageBuildData build, string packagePath) : base(build, packagePath)
     { }
@@ -282,7 +666,7 @@ internal class PackageWriter_V7<THeader, TFile> : PackageWriter
         Metadata.Md5 = ComputeArchiveHash();
 
         var header = (THeader)THeader.FromCommonHeader(Metadata);
-        BinUtils.WriteStruct(writer, ref header);
+        BinUtils.WriteStruct(writer, header);
 
         WriteFileList<TFile>(writer, writtenFiles);
     }
@@ -290,8 +674,8 @@ internal class PackageWriter_V7<THeader, TFile> : PackageWriter
 
 
 internal class PackageWriter_V13<THeader, TFile> : PackageWriter
-    where THeader : ILSPKHeader
-    where TFile : ILSPKFile
+    where THeader : unmanaged, ILSPKHeader
+    where TFile : unmanaged, ILSPKFile
 {
     public PackageWriter_V13(PackageBuildData build, string packagePath) : base(build, packagePath)
     { }
@@ -310,7 +694,7 @@ internal class PackageWriter_V13<THeader, TFile> : PackageWriter
         Metadata.NumParts = (UInt16)Streams.Count;
 
         var header = (THeader)THeader.FromCommonHeader(Metadata);
-        BinUtils.WriteStruct(writer, ref header);
+        BinUtils.WriteStruct(writer, header);
 
         writer.Write((UInt32)(8 + Marshal.SizeOf(typeof(THeader))));
         writer.Write(PackageHeaderCommon.Signature);
@@ -319,19 +703,21 @@ internal class PackageWriter_V13<THeader, TFile> : PackageWriter
 
 
 internal class PackageWriter_V15<THeader, TFile> : PackageWriter
-    where THeader : ILSPKHeader
-    where TFile : ILSPKFile
+    where THeader : unmanaged, ILSPKHeader
+    where TFile : unmanaged, ILSPKFile
 {
     public PackageWriter_V15(PackageBuildData build, string packagePath) : base(build, packagePath)
     { }
 
+    protected override bool HasArchiveHash => Build.Hash;
+
     public override void Write()
     {
         using (var writer = new BinaryWriter(MainStream, new UTF8Encoding(), true))
         {
             writer.Write(PackageHeaderCommon.Signature);
             var header = (THeader)THeader.FromCommonHeader(Metadata);
-            BinUtils.WriteStruct(writer, ref header);
+            BinUtils.WriteStruct(writer, header);
         }
 
         var writtenFiles = PackFiles();
@@ -355,7 +741,7 @@ internal class PackageWriter_V15<THeader, TFile> : PackageWriter
 
             MainStream.Seek(4, SeekOrigin.Begin);
             var header = (THeader)THeader.FromCommonHeader(Metadata);
-            BinUtils.WriteStruct(writer, ref header);
+            BinUtils.WriteStruct(writer, header);
         }
     }
 }
@@ -0,0 +1,66 @@
+﻿using LSLib.Native;
+
+namespace LSLib.LS;
+
+/// <summary>
+/// Converts PhysX collections between the binary format used by the game and XML
+/// using the in-process PhysicsTool library.
+/// </summary>
+public static class PhysicsConversion
+{
+    // Number of bytes checked for the document element of XML collections
+    private const int XmlProbeSize = 0x100;
+
+    public static bool IsBinaryCollection(ReadOnlySpan<byte> data)
+    {
+        // PhysX binary serialization header
+        return data.StartsWith("SEBD"u8);
+    }
+
+    public static bool IsXmlCollection(ReadOnlySpan<byte> data)
+    {
+        var head = data[..Math.Min(data.Length, XmlProbeSize)];
+        return head.IndexOf("<BG3Physics"u8) >= 0;
+    }
+
+    public static bool IsXmlCollection(PackageBuildInputFile file)
+    {
+        if (file.Body != null)
+        {
+            return IsXmlCollection(file.Body);
+        }
+
+        Span<byte> head = stackalloc byte[XmlProbeSize];
+        using var stream = file.MakeInputStream();
+        var length = stream.ReadAtLeast(head, head.Length, false);
+        return IsXmlCollection(head[..length]);
+    }
+
+    public static byte[] ToXml(byte[] binary)
+    {
+        return PhysicsConverter.Convert(binary, PhysicsFormat.Binary, PhysicsFormat.Xml);
+    }
+
+    public static byte[] ToBinary(byte[] xml)
+    {
+        return PhysicsConverter.Convert(xml, PhysicsFormat.Xml, PhysicsFormat.Binary);
+    }
+
+    /// <summary>
+    /// Loads a binary collection that other collections were serialized against,
+    /// e.g. the shared material collection written by PhysicsTool --shared-materials.
+    /// </summary>
+    public static PhysicsExternalRefs LoadExternalRefs(byte[] binary)
+    {
+        return new PhysicsExternalRefs(binary);
+    }
+
+    /// <summary>
+    /// Converts a binary collection that references objects of another collection.
+    /// The XML output contains a copy of the referenced objects.
+    /// </summary>
+    public static byte[] ToXml(byte[] binary, PhysicsExternalRefs externalRefs)
+    {
+        return PhysicsConverter.Convert(binary, PhysicsFormat.Binary, PhysicsFormat.Xml, externalRefs);
+    }
+}
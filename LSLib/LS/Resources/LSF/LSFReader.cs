@@ -110,7 +110,7 @@ public class LSFReader(Stream stream, bool keepOpen = false) : IDisposable
 
             if (longNodes)
             {
-                var item = BinUtils.ReadStruct<LSFNodeEntryV3>(reader);
+                BinUtils.ReadStruct(reader, out LSFNodeEntryV3 item);
                 resolved.ParentIndex = item.ParentIndex;
                 resolved.NameIndex = item.NameIndex;
                 resolved.NameOffset = item.NameOffset;
@@ -118,7 +118,7 @@ public class LSFReader(Stream stream, bool keepOpen = false) : IDisposable
             }
             else
             {
-                var item = BinUtils.ReadStruct<LSFNodeEntryV2>(reader);
+                BinUtils.ReadStruct(reader, out LSFNodeEntryV2 item);
                 resolved.ParentIndex = item.ParentIndex;
                 resolved.NameIndex = item.NameIndex;
                 resolved.NameOffset = item.NameOffset;
@@ -154,7 +154,7 @@ public class LSFReader(Stream stream, bool keepOpen = false) : IDisposable
         Int32 index = 0;
         while (s.Position < s.Length)
         {
-            var attribute = BinUtils.ReadStruct<LSFAttributeEntryV2>(reader);
+            BinUtils.ReadStruct(reader, out LSFAttributeEntryV2 attribute);
 
             var resolved = new LSFAttributeInfo
             {
@@ -228,7 +228,7 @@ public class LSFReader(Stream stream, bool keepOpen = false) : IDisposable
         using var reader = new BinaryReader(s);
         while (s.Position < s.Length)
         {
-            var attribute = BinUtils.ReadStruct<LSFAttributeEntryV3>(reader);
+            BinUtils.ReadStruct(reader, out LSFAttributeEntryV3 attribute);
 
             var resolved = new LSFAttributeInfo
             {
@@ -273,7 +273,7 @@ public class LSFReader(Stream stream, bool keepOpen = false) : IDisposable
 
         while (s.Position < s.Length)
         {
-            var key = BinUtils.ReadStruct<LSFKeyEntry>(reader);
+            BinUtils.ReadStruct(reader, out LSFKeyEntry key);
             var KeyAttribute = Names[key.KeyNameIndex][key.KeyNameOffset];
             var node = Nodes[(int)key.NodeIndex];
             node.KeyAttribute = KeyAttribute;
@@ -327,7 +327,7 @@ public class LSFReader(Stream stream, bool keepOpen = false) : IDisposable
 
     private void ReadHeaders(BinaryReader reader)
     {
-        var magic = BinUtils.ReadStruct<LSFMagic>(reader);
+        BinUtils.ReadStruct(reader, out LSFMagic magic);
         if (magic.Magic != BitConverter.ToUInt32(LSFMagic.Signature, 0))
         {
             var msg = String.Format(
@@ -347,7 +347,7 @@ public class LSFReader(Stream stream, bool keepOpen = false) : IDisposable
 
         if (Version >= LSFVersion.VerBG3ExtendedHeader)
         {
-            var hdr = BinUtils.ReadStruct<LSFHeaderV5>(reader);
+            BinUtils.ReadStruct(reader, out LSFHeaderV5 hdr);
             GameVersion = PackedVersion.FromInt64(hdr.EngineVersion);
 
             // Workaround for merged LSF files with missing engine version number
@@ -361,13 +361,13 @@ public class LSFReader(Stream stream, bool keepOpen = false) : IDisposable
         }
         else
         {
-            var hdr = BinUtils.ReadStruct<LSFHeader>(reader);
+            BinUtils.ReadStruct(reader, out LSFHeader hdr);
             GameVersion = PackedVersion.FromInt32(hdr.EngineVersion);
         }
 
         if (Version < LSFVersion.VerBG3NodeKeys)
         {
-            var meta = BinUtils.ReadStruct<LSFMetadataV5>(reader);
+            BinUtils.ReadStruct(reader, out LSFMetadataV5 meta);
             Metadata = new LSFMetadataV6
             {
                 StringsUncompressedSize = meta.StringsUncompressedSize,
@@ -384,7 +384,7 @@ public class LSFReader(Stream stream, bool keepOpen = false) : IDisposable
         }
         else
         {
-            Metadata = BinUtils.ReadStruct<LSFMetadataV6>(reader);
+            BinUtils.ReadStruct(reader, out Metadata);
         }
     }
 
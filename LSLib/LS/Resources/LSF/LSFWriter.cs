@@ -88,7 +88,7 @@ public class LSFWriter(Stream stream)
                 Magic = BitConverter.ToUInt32(LSFMagic.Signature, 0),
                 Version = (uint)Version
             };
-            BinUtils.WriteStruct<LSFMagic>(Writer, ref magic);
+            BinUtils.WriteStruct(Writer, magic);
 
             PackedVersion gameVersion = new()
             {
@@ -104,7 +104,7 @@ public class LSFWriter(Stream stream)
                 {
                     EngineVersion = gameVersion.ToVersion32()
                 };
-                BinUtils.WriteStruct<LSFHeader>(Writer, ref header);
+                BinUtils.WriteStruct(Writer, header);
             }
             else
             {
@@ -112,7 +112,7 @@ public class LSFWriter(Stream stream)
                 {
                     EngineVersion = gameVersion.ToVersion64()
                 };
-                BinUtils.WriteStruct<LSFHeaderV5>(Writer, ref header);
+                BinUtils.WriteStruct(Writer, header);
             }
 
             bool chunked = Version >= LSFVersion.VerChunkedCompress;
@@ -162,7 +162,7 @@ public class LSFWriter(Stream stream)
                 meta.Unknown3 = 0;
                 meta.MetadataFormat = MetadataFormat;
 
-                BinUtils.WriteStruct<LSFMetadataV5>(Writer, ref meta);
+                BinUtils.WriteStruct(Writer, meta);
             }
             else
             {
@@ -197,7 +197,7 @@ public class LSFWriter(Stream stream)
                 meta.Unknown3 = 0;
                 meta.MetadataFormat = MetadataFormat;
 
-                BinUtils.WriteStruct<LSFMetadataV6>(Writer, ref meta);
+                BinUtils.WriteStruct(Writer, meta);
             }
 
             Writer.Write(stringsCompressed, 0, stringsCompressed.Length);
@@ -279,7 +279,7 @@ public class LSFWriter(Stream stream)
             attributeInfo.TypeAndLength = (UInt32)entry.Value.Type | (length << 6);
             attributeInfo.NameHashTableIndex = AddStaticString(entry.Key);
             attributeInfo.NodeIndex = NextNodeIndex;
-            BinUtils.WriteStruct<LSFAttributeEntryV2>(AttributeWriter, ref attributeInfo);
+            BinUtils.WriteStruct(AttributeWriter, attributeInfo);
             NextAttributeIndex++;
 
             lastOffset = (UInt32)ValueStream.Position;
@@ -308,7 +308,7 @@ public class LSFWriter(Stream stream)
                 attributeInfo.NextAttributeIndex = NextAttributeIndex + 1;
             }
             attributeInfo.Offset = lastOffset;
-            BinUtils.WriteStruct<LSFAttributeEntryV3>(AttributeWriter, ref attributeInfo);
+            BinUtils.WriteStruct(AttributeWriter, attributeInfo);
 
             NextAttributeIndex++;
 
@@ -359,7 +359,7 @@ public class LSFWriter(Stream stream)
             nodeInfo.FirstAttributeIndex = -1;
         }
 
-        BinUtils.WriteStruct<LSFNodeEntryV2>(NodeWriter, ref nodeInfo);
+        BinUtils.WriteStruct(NodeWriter, nodeInfo);
         NodeIndices[node] = NextNodeIndex;
         NextNodeIndex++;
 
@@ -393,7 +393,7 @@ public class LSFWriter(Stream stream)
             nodeInfo.FirstAttributeIndex = -1;
         }
 
-        BinUtils.WriteStruct<LSFNodeEntryV3>(NodeWriter, ref nodeInfo);
+        BinUtils.WriteStruct(NodeWriter, nodeInfo);
 
         if (node.KeyAttribute != null && MetadataFormat == LSFMetadataFormat.KeysAndAdjacency)
         {
@@ -402,7 +402,7 @@ public class LSFWriter(Stream stream)
                 NodeIndex = (UInt32)NextNodeIndex,
                 KeyName = AddStaticString(node.KeyAttribute)
             };
-            BinUtils.WriteStruct<LSFKeyEntry>(KeyWriter, ref keyInfo);
+            BinUtils.WriteStruct(KeyWriter, keyInfo);
         }
 
         NodeIndices[node] = NextNodeIndex;
@@ -1,63 +1,22 @@
-﻿namespace LSLib.LS;
+﻿using System.Runtime.ExceptionServices;
 
-public class VFSDirectory
-{
-    public string Path;
-    public Dictionary<string, VFSDirectory> Dirs;
-    public Dictionary<string, PackagedFileInfo> Files;
-
-    public VFSDirectory GetOrAddDirectory(string absolutePath, string name)
-    {
-        Dirs ??= [];
-
-        if (!Dirs.TryGetValue(name, out var dir))
-        {
-            dir = new VFSDirectory();
-            dir.Path = absolutePath;
-            Dirs[name] = dir;
-        }
-
-        return dir;
-    }
-
-    public bool TryGetDirectory(string name, out VFSDirectory dir)
-    {
-        if (Dirs?.TryGetValue(name, out dir) == true)
-        {
-            return true;
-        }
-
-        dir = null;
-        return false;
-    }
-
-    public void AddFile(string name, PackagedFileInfo file)
-    {
-        Files ??= [];
-
-        if (!Files.TryGetValue(name, out var curFile) || curFile.Package.Metadata.Priority < file.Package.Metadata.Priority)
-        {
-            Files[name] = file;
-        }
-    }
-
-    public bool TryGetFile(string name, out PackagedFileInfo file)
-    {
-        if (Files?.TryGetValue(name, out file) == true)
-        {
-            return true;
-        }
-
-        file = null;
-        return false;
-    }
-}
+namespace LSLib.LS;
 
 public class VFS : IDisposable
 {
     private List<Package> Packages = [];
     private string RootDir;
-    private VFSDirectory Root = new();
+    private VFSPathTable Table = VFSPathTable.Empty;
+    private VFSPathIndex Index = VFSPathIndex.Empty;
+    // Number of packages opened or indexed concurrently; 0 = use all cores
+    public int MaxParallelism = 0;
+    // File table cache for the packages of AttachGameDirectory(); not used if null.
+    // Packages restored from a snapshot don't have their Files list populated.
+    public string SnapshotPath = null;
+    // Number of packages whose files were already added to the path table
+    private int IndexedPackages = 0;
+    // Number of packages to save in the snapshot during the next FinishBuild()
+    private int SnapshotPackages = 0;
 
     public void Dispose()
     {
@@ -115,29 +74,38 @@ public class VFS : IDisposable
             ];
         }
 
-        // Collect priority value from headers
-        var packagePriorities = new List<Tuple<string, int>>();
+        List<string> packagePaths = [];
+        var gamePaks = Directory.GetFiles(gameDataPath, "*.pak");
+        var localizationPaks = Directory.GetFiles(Path.Join(gameDataPath, "Localization"), "*.pak");
 
-        foreach (var path in Directory.GetFiles(gameDataPath, "*.pak"))
+        foreach (var path in gamePaks.Concat(localizationPaks))
         {
             var baseName = Path.GetFileName(path);
             if (!packageBlacklist.Contains(baseName)
                 // Don't load 2nd, 3rd, ... parts of a multi-part archive
                 && !ModPathVisitor.archivePartRe.IsMatch(baseName))
             {
-                AttachPackage(path);
+                packagePaths.Add(path);
             }
         }
 
-        foreach (var path in Directory.GetFiles(Path.Join(gameDataPath, "Localization"), "*.pak"))
+        if (SnapshotPath != null && Packages.Count == 0)
         {
-            var baseName = Path.GetFileName(path);
-            if (!packageBlacklist.Contains(baseName)
-                // Don't load 2nd, 3rd, ... parts of a multi-part archive
-                && !ModPathVisitor.archivePartRe.IsMatch(baseName))
+            if (VFSSnapshot.TryLoad(SnapshotPath, packagePaths, out var packages, out var index))
             {
-                AttachPackage(path);
+                Packages.AddRange(packages);
+                Table = VFSPathTable.Build(index.VisibleFiles);
+                Index = index;
+                IndexedPackages = Packages.Count;
+                return;
             }
+
+            AttachPackages(packagePaths);
+            SnapshotPackages = Packages.Count;
+        }
+        else
+        {
+            AttachPackages(packagePaths);
         }
     }
 
@@ -148,102 +116,100 @@ public class VFS : IDisposable
         Packages.Add(package);
     }
 
+    // Opens packages concurrently; they're attached in the order they were passed in,
+    // regardless of which one finished loading first.
+    public void AttachPackages(IList<string> paths)
+    {
+        var packages = new Package[paths.Count];
+        try
+        {
+            RunParallel(paths.Count, i => packages[i] = new PackageReader().Read(paths[i]));
+        }
+        finally
+        {
+            // Keep whatever did open so Dispose() releases it if another package failed
+            Packages.AddRange(packages.Where(p => p != null));
+        }
+    }
+
     public void FinishBuild()
     {
-        foreach (var package in Packages)
+        var newPackages = Packages.Skip(IndexedPackages);
+
+        // File lists are decoded on first access; do that for all packages at once
+        var pending = newPackages.ToList();
+        RunParallel(pending.Count, i => _ = pending[i].Files.Count);
+
+        if (SnapshotPackages > 0 && IndexedPackages == 0)
         {
-            foreach (var file in package.Files)
-            {
-                TryAddFile(file);
-            }
+            // Snapshot only contains the game directory, not packages attached after it
+            Table = VFSPathTable.Build(Packages.Take(SnapshotPackages).Select(p => p.Files).ToList(), MaxParallelism);
+            Index = VFSPathIndex.Build(Table.VisibleFiles);
+            SaveSnapshot(Packages.GetRange(0, SnapshotPackages));
+            newPackages = Packages.Skip(SnapshotPackages);
+        }
+
+        if (newPackages.Any())
+        {
+            // Files already in the table come from earlier packages, so they go first to keep tie-breaking stable
+            Table = VFSPathTable.Build([Table.VisibleFiles, .. newPackages.Select(p => p.Files)], MaxParallelism);
+            Index = VFSPathIndex.Build(Table.VisibleFiles);
         }
+
+        IndexedPackages = Packages.Count;
+        SnapshotPackages = 0;
     }
 
-    private void TryAddFile(PackagedFileInfo file)
+    private void SaveSnapshot(List<Package> packages)
     {
-        var path = file.Name;
-        var namePos = 0;
-        var node = Root;
-        do
+        try
         {
-            var endPos = path.IndexOf('/', namePos);
-            if (endPos >= 0)
-            {
-                node = node.GetOrAddDirectory(path.Substring(0, endPos), path.Substring(namePos, endPos - namePos));
-                namePos = endPos + 1;
-            }
-            else
-            {
-                node.AddFile(path.Substring(namePos), file);
-                break;
-            }
-        } while (true);
+            VFSSnapshot.Save(SnapshotPath, packages, Index);
+        }
+        catch (Exception e) when (e is IOException || e is UnauthorizedAccessException)
+        {
+            // The snapshot is only a cache; the next run will try to write it again
+        }
     }
 
-    public VFSDirectory FindVFSDirectory(string path)
+    private void RunParallel(int count, Action<int> action)
     {
-        var namePos = 0;
-        var node = Root;
-        do
+        var options = new ParallelOptions
         {
-            var endPos = path.IndexOf('/', namePos);
-            if (endPos >= 0)
-            {
-                if (!node.TryGetDirectory(path.Substring(namePos, endPos - namePos), out node))
-                {
-                    return null;
-                }
+            MaxDegreeOfParallelism = MaxParallelism > 0 ? MaxParallelism : Environment.ProcessorCount
+        };
 
-                namePos = endPos + 1;
-            }
-            else
-            {
-                if (node.TryGetDirectory(path.Substring(namePos), out node))
-                {
-                    return node;
-                }
-                else
-                {
-                    return null;
-                }
-            }
-        } while (true);
+        try
+        {
+            Parallel.For(0, count, options, action);
+        }
+        catch (AggregateException e) when (e.InnerExceptions.Count == 1)
+        {
+            ExceptionDispatchInfo.Capture(e.InnerException).Throw();
+        }
     }
 
     public bool DirectoryExists(string path)
     {
-        if (FindVFSDirectory(Canonicalize(path)) != null) return true;
+        if (Table.FindDirectory(path) >= 0) return true;
         return RootDir != null && Directory.Exists(Path.Combine(RootDir, path));
     }
 
     public PackagedFileInfo FindVFSFile(string path)
     {
-        var namePos = 0;
-        var node = Root;
-        do
-        {
-            var endPos = path.IndexOf('/', namePos);
-            if (endPos >= 0)
-            {
-                if (!node.TryGetDirectory(path.Substring(namePos, endPos - namePos), out node))
-                {
-                    return null;
-                }
+        return Index.Find(path);
+    }
 
-                namePos = endPos + 1;
-            }
-            else
-            {
-                if (node.TryGetFile(path.Substring(namePos), out var file))
-                {
-                    return file;
-                }
-                else
-                {
-                    return null;
-                }
-            }
-        } while (true);
+    // Packaged files whose path starts with the given string; loose files aren't included
+    public IEnumerable<PackagedFileInfo> FindVFSFilesByPrefix(string prefix)
+    {
+        return Index.FindByPrefix(prefix).Where(file => !file.IsDeletion());
+    }
+
+    // Packaged files matching a wildcard pattern ('*' and '?'); loose files aren't included
+    public IEnumerable<PackagedFileInfo> FindVFSFilesByPattern(string pattern)
+    {
+        return Index.FindByPattern(pattern).Where(file => !file.IsDeletion());
     }
 
     public string Canonicalize(string path)
@@ -253,7 +219,7 @@ public class VFS : IDisposable
 
     public bool FileExists(string path)
     {
-        if (FindVFSFile(Canonicalize(path)) != null) return true;
+        if (Index.Find(path) != null) return true;
         return RootDir != null && File.Exists(Path.Combine(RootDir, path));
     }
 
@@ -271,8 +237,8 @@ public class VFS : IDisposable
 
     public void EnumerateFiles(List<string> results, string path, bool recursive, Func<string, bool> filter)
     {
-        var dir = FindVFSDirectory(Canonicalize(path));
-        if (dir != null)
+        var dir = Table.FindDirectory(path);
+        if (dir >= 0)
         {
             EnumerateFiles(results, dir, recursive, filter);
         }
@@ -303,12 +269,15 @@ public class VFS : IDisposable
 
     public void EnumerateDirectories(List<string> results, string path)
     {
-        var dir = FindVFSDirectory(Canonicalize(path));
-        if (dir?.Dirs != null)
+        var dir = Table.FindDirectory(path);
+        if (dir >= 0)
         {
-            foreach (var subdir in dir.Dirs)
+            foreach (var child in Table.GetChildren(dir))
             {
-                results.Add(subdir.Value.Path);
+                if (Table.IsDirectory(child))
+                {
+                    results.Add(Table.GetPath(child));
+                }
             }
         }
 
@@ -325,31 +294,32 @@ public class VFS : IDisposable
         }
     }
 
-    private void EnumerateFiles(List<string> results, VFSDirectory dir, bool recursive, Func<string, bool> filter)
+    private void EnumerateFiles(List<string> results, int dir, bool recursive, Func<string, bool> filter)
     {
-        if (dir.Files != null)
+        foreach (var child in Table.GetChildren(dir))
         {
-            foreach (var file in dir.Files)
+            var file = Table.GetFile(child);
+            if (file != null && !file.IsDeletion() && filter(Table.GetName(child)))
             {
-                if (!file.Value.IsDeletion() && filter(file.Key))
-                {
-                    results.Add(file.Value.Name);
-                }
+                results.Add(file.Name);
             }
         }
 
-        if (recursive && dir.Dirs != null)
+        if (recursive)
         {
-            foreach (var subdir in dir.Dirs)
+            foreach (var child in Table.GetChildren(dir))
             {
-                EnumerateFiles(results, subdir.Value, recursive, filter);
+                if (Table.IsDirectory(child))
+                {
+                    EnumerateFiles(results, child, recursive, filter);
+                }
             }
         }
     }
 
     public bool TryOpenFromVFS(string path, out Stream stream)
     {
-        var file = FindVFSFile(Canonicalize(path));
+        var file = Index.Find(path);
         if (file != null && !file.IsDeletion())
         {
             stream = file.CreateContentReader();
@@ -0,0 +1,213 @@
+﻿using System.Buffers;
+using System.IO.Enumeration;
+using System.IO.Hashing;
+using System.Numerics;
+
+namespace LSLib.LS;
+
+// Flat index of every file visible through the VFS.
+// Paths are keyed by a 64-bit hash of their case-folded form, so resolving a full path is a single probe
+// into an open-addressing table. The hash doesn't depend on the process, so it can be stored in a VFS
+// snapshot. A second array lists the files in path order for prefix and wildcard queries.
+public sealed class VFSPathIndex
+{
+    private const int MaxStackPath = 0x200;
+
+    private readonly PackagedFileInfo[] Files;
+    // Path hash of each entry in Files
+    private readonly ulong[] Hashes;
+    // Hash table slots; a slot is empty if SlotFiles is -1
+    private readonly ulong[] SlotKeys;
+    private readonly int[] SlotFiles;
+    // Indices of Files ordered by folded path
+    private readonly int[] Sorted;
+
+    public static readonly VFSPathIndex Empty = Build([]);
+
+    public int Count => Files.Length;
+    public IReadOnlyList<PackagedFileInfo> VisibleFiles => Files;
+    internal ReadOnlySpan<ulong> PathHashes => Hashes;
+    internal ReadOnlySpan<int> SortedOrder => Sorted;
+
+    private VFSPathIndex(PackagedFileInfo[] files, ulong[] hashes, int[] sorted)
+    {
+        var capacity = (int)BitOperations.RoundUpToPowerOf2((uint)Math.Max(16, files.Length * 2));
+        SlotKeys = new ulong[capacity];
+        SlotFiles = new int[capacity];
+        Array.Fill(SlotFiles, -1);
+
+        // Resolve duplicate paths by package priority; ties go to the file listed first
+        List<PackagedFileInfo> visible = new(files.Length);
+        List<ulong> visibleHashes = new(files.Length);
+        for (var i = 0; i < files.Length; i++)
+        {
+            var slot = FindSlot(hashes[i], files[i].Name, SlotKeys, SlotFiles, visible);
+            if (SlotFiles[slot] < 0)
+            {
+                SlotKeys[slot] = hashes[i];
+                SlotFiles[slot] = visible.Count;
+                visible.Add(files[i]);
+                visibleHashes.Add(hashes[i]);
+            }
+            else if (visible[SlotFiles[slot]].Package.Metadata.Priority < files[i].Package.Metadata.Priority)
+            {
+                visible[SlotFiles[slot]] = files[i];
+            }
+        }
+
+        Files = visible.ToArray();
+        Hashes = visibleHashes.ToArray();
+
+        if (sorted == null || Files.Length != files.Length)
+        {
+            sorted = new int[Files.Length];
+            for (var i = 0; i < sorted.Length; i++)
+            {
+                sorted[i] = i;
+            }
+
+            var names = Files;
+            Array.Sort(sorted, (a, b) => ComparePaths(names[a].Name, names[b].Name));
+        }
+
+        Sorted = sorted;
+    }
+
+    public static VFSPathIndex Build(IReadOnlyList<PackagedFileInfo> files)
+    {
+        var fileArray = files.ToArray();
+        var hashes = new ulong[fileArray.Length];
+        for (var i = 0; i < fileArray.Length; i++)
+        {
+            hashes[i] = HashPath(fileArray[i].Name);
+        }
+
+        return new VFSPathIndex(fileArray, hashes, null);
+    }
+
+    // Restores an index from hashes and path order saved with the same list of files
+    internal static VFSPathIndex FromSnapshot(PackagedFileInfo[] files, ulong[] hashes, int[] sorted)
+    {
+        if (hashes.Length != files.Length || sorted.Length != files.Length
+            || sorted.Any(index => (uint)index >= (uint)files.Length))
+        {
+            throw new InvalidDataException("Path index doesn't match the file list");
+        }
+
+        return new VFSPathIndex(files, hashes, sorted);
+    }
+
+    private static char Fold(char c) => c == '\\' ? '/' : char.ToUpperInvariant(c);
+
+    public static ulong HashPath(ReadOnlySpan<char> path)
+    {
+        char[] rented = null;
+        Span<char> folded = path.Length <= MaxStackPath
+            ? stackalloc char[MaxStackPath]
+            : (rented = ArrayPool<char>.Shared.Rent(path.Length));
+
+        for (var i = 0; i < path.Length; i++)
+        {
+            folded[i] = Fold(path[i]);
+        }
+
+        var hash = XxHash64.HashToUInt64(MemoryMarshal.AsBytes(folded[..path.Length]));
+        if (rented != null)
+        {
+            ArrayPool<char>.Shared.Return(rented);
+        }
+
+        return hash;
+    }
+
+    public static bool PathEquals(ReadOnlySpan<char> a, ReadOnlySpan<char> b)
+    {
+        if (a.Length != b.Length) return false;
+
+        for (var i = 0; i < a.Length; i++)
+        {
+            if (a[i] != b[i] && Fold(a[i]) != Fold(b[i])) return false;
+        }
+
+        return true;
+    }
+
+    public static int ComparePaths(ReadOnlySpan<char> a, ReadOnlySpan<char> b)
+    {
+        var len = Math.Min(a.Length, b.Length);
+        for (var i = 0; i < len; i++)
+        {
+            var cmp = Fold(a[i]).CompareTo(Fold(b[i]));
+            if (cmp != 0) return cmp;
+        }
+
+        return a.Length.CompareTo(b.Length);
+    }
+
+    // Returns the slot holding the path, or the empty slot where it would be inserted
+    private static int FindSlot(ulong hash, ReadOnlySpan<char> path, ulong[] keys, int[] files, IReadOnlyList<PackagedFileInfo> fileList)
+    {
+        var mask = keys.Length - 1;
+        var slot = (int)hash & mask;
+        while (files[slot] >= 0)
+        {
+            if (keys[slot] == hash && PathEquals(fileList[files[slot]].Name, path)) break;
+            slot = (slot + 1) & mask;
+        }
+
+        return slot;
+    }
+
+    // Looks up a full path; '/' and '\' are both accepted as separators
+    public PackagedFileInfo Find(ReadOnlySpan<char> path)
+    {
+        var slot = FindSlot(HashPath(path), path, SlotKeys, SlotFiles, Files);
+        return SlotFiles[slot] >= 0 ? Files[SlotFiles[slot]] : null;
+    }
+
+    private static bool StartsWithPath(ReadOnlySpan<char> path, ReadOnlySpan<char> prefix)
+    {
+        return path.Length >= prefix.Length && PathEquals(path[..prefix.Length], prefix);
+    }
+
+    // Files whose path starts with the given string, in path order
+    public IEnumerable<PackagedFileInfo> FindByPrefix(string prefix)
+    {
+        // Lower bound of the prefix in path order
+        var lo = 0;
+        var hi = Sorted.Length;
+        while (lo < hi)
+        {
+            var mid = lo + ((hi - lo) >> 1);
+            if (ComparePaths(Files[Sorted[mid]].Name, prefix) < 0)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+
+        for (var i = lo; i < Sorted.Length && StartsWithPath(Files[Sorted[i]].Name, prefix); i++)
+        {
+            yield return Files[Sorted[i]];
+        }
+    }
+
+    // Files matching a wildcard pattern ('*' and '?'; '*' also matches across directories), in path order.
+    // The part of the pattern before the first wildcard is used to narrow down the search.
+    public IEnumerable<PackagedFileInfo> FindByPattern(string pattern)
+    {
+        var wildcard = pattern.AsSpan().IndexOfAny('*', '?');
+        if (wildcard < 0)
+        {
+            var file = Find(pattern);
+            return file != null ? new[] { file } : Array.Empty<PackagedFileInfo>();
+        }
+
+        var canonical = pattern.Replace('\\', '/');
+        return FindByPrefix(pattern[..wildcard])
+            .Where(file => FileSystemName.MatchesSimpleExpression(canonical, file.Name, true));
+    }
+}
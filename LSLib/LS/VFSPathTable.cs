@@ -0,0 +1,364 @@
+﻿using System.Runtime.ExceptionServices;
+
+namespace LSLib.LS;
+
+// Directory tree of the VFS, stored as flat arrays.
+// Path segments are interned once and matched case-insensitively. The children of each node are a
+// contiguous slice of Children, ordered by the hash of their name, so resolving a path is one hash
+// and one binary search over integers per segment, and doesn't allocate. The hash is randomized per
+// process, so enumeration uses a second copy of the slices (OrderedChildren) kept in insertion order.
+public sealed class VFSPathTable
+{
+    private struct Node
+    {
+        // Index into Segments; -1 for the root
+        public int Name;
+        public int Parent;
+        // Slice of Children
+        public int FirstChild;
+        public int NumChildren;
+        // Index into Files; -1 if the node is only a directory
+        public int File;
+    }
+
+    public const int RootNode = 0;
+
+    private readonly string[] Segments;
+    private readonly Node[] Nodes;
+    private readonly int[] Children;
+    // Name hash of each entry in Children
+    private readonly int[] ChildHashes;
+    // Same slices as Children, in the order the nodes were added
+    private readonly int[] OrderedChildren;
+    private readonly PackagedFileInfo[] Files;
+
+    public static readonly VFSPathTable Empty = Build([]);
+
+    private VFSPathTable(string[] segments, Node[] nodes, int[] children, int[] childHashes, int[] orderedChildren, PackagedFileInfo[] files)
+    {
+        Segments = segments;
+        Nodes = nodes;
+        Children = children;
+        ChildHashes = childHashes;
+        OrderedChildren = orderedChildren;
+        Files = files;
+    }
+
+    private static int Hash(ReadOnlySpan<char> s) => string.GetHashCode(s, StringComparison.OrdinalIgnoreCase);
+
+    // Files visible through the table, one per path
+    public IReadOnlyList<PackagedFileInfo> VisibleFiles => Files;
+
+    public int SegmentCount => Segments.Length;
+    public int NodeCount => Nodes.Length;
+
+    // Builds the table from files listed in mount order. If the same path occurs more than once,
+    // the file from the package with the highest priority is kept; ties go to the earliest one.
+    public static VFSPathTable Build(IEnumerable<PackagedFileInfo> files)
+    {
+        var fragment = new Fragment();
+        foreach (var file in files)
+        {
+            fragment.Add(file);
+        }
+
+        return fragment.ToTable();
+    }
+
+    // Same as Build(), for files split into consecutive groups (usually one per package).
+    // Each group is parsed into a fragment on its own thread; the fragments are then merged in order,
+    // which only touches each distinct node once, so the result is identical to a sequential build.
+    public static VFSPathTable Build(IReadOnlyList<IEnumerable<PackagedFileInfo>> groups, int maxParallelism = 0)
+    {
+        var options = new ParallelOptions
+        {
+            MaxDegreeOfParallelism = maxParallelism > 0 ? maxParallelism : Environment.ProcessorCount
+        };
+
+        // Merging costs about a third of a sequential build, so it only pays off with more than one thread
+        if (groups.Count < 2 || options.MaxDegreeOfParallelism == 1)
+        {
+            return Build(groups.SelectMany(files => files));
+        }
+
+        var fragments = new Fragment[groups.Count];
+
+        try
+        {
+            Parallel.For(0, groups.Count, options, i =>
+            {
+                var fragment = new Fragment();
+                foreach (var file in groups[i])
+                {
+                    fragment.Add(file);
+                }
+                fragments[i] = fragment;
+            });
+        }
+        catch (AggregateException e) when (e.InnerExceptions.Count == 1)
+        {
+            ExceptionDispatchInfo.Capture(e.InnerException).Throw();
+        }
+
+        var merged = fragments[0];
+        for (var i = 1; i < fragments.Length; i++)
+        {
+            merged.Merge(fragments[i]);
+        }
+
+        return merged.ToTable();
+    }
+
+    private static int[] BuildChildren(Node[] nodes, int[] segmentHashes, out int[] childHashes, out int[] orderedChildren)
+    {
+        for (var i = 1; i < nodes.Length; i++)
+        {
+            nodes[nodes[i].Parent].NumChildren++;
+        }
+
+        var offset = 0;
+        for (var i = 0; i < nodes.Length; i++)
+        {
+            nodes[i].FirstChild = offset;
+            offset += nodes[i].NumChildren;
+            nodes[i].NumChildren = 0;
+        }
+
+        var children = new int[nodes.Length - 1];
+        childHashes = new int[nodes.Length - 1];
+        for (var i = 1; i < nodes.Length; i++)
+        {
+            ref var parent = ref nodes[nodes[i].Parent];
+            var index = parent.FirstChild + parent.NumChildren++;
+            children[index] = i;
+            childHashes[index] = segmentHashes[nodes[i].Name];
+        }
+
+        // Nodes are numbered in insertion order, so the slices are in insertion order until sorted
+        orderedChildren = (int[])children.Clone();
+        for (var i = 0; i < nodes.Length; i++)
+        {
+            if (nodes[i].NumChildren > 1)
+            {
+                Array.Sort(childHashes, children, nodes[i].FirstChild, nodes[i].NumChildren);
+            }
+        }
+
+        return children;
+    }
+
+    private int FindChild(int node, ReadOnlySpan<char> name)
+    {
+        var hash = Hash(name);
+        var first = Nodes[node].FirstChild;
+        var end = first + Nodes[node].NumChildren;
+
+        // Find the first child with a matching hash, then check names of all children sharing it
+        var lo = first;
+        var hi = end;
+        while (lo < hi)
+        {
+            var mid = lo + ((hi - lo) >> 1);
+            if (ChildHashes[mid] < hash)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+
+        for (; lo < end && ChildHashes[lo] == hash; lo++)
+        {
+            var child = Children[lo];
+            if (name.Equals(Segments[Nodes[child].Name], StringComparison.OrdinalIgnoreCase)) return child;
+        }
+
+        return -1;
+    }
+
+    // Resolves a path to a node; both '/' and '\' are accepted as separators. Returns -1 if not found.
+    public int FindNode(ReadOnlySpan<char> path)
+    {
+        var node = RootNode;
+        while (true)
+        {
+            var endPos = path.IndexOfAny('/', '\\');
+            node = FindChild(node, endPos >= 0 ? path[..endPos] : path);
+            if (node < 0 || endPos < 0) return node;
+            path = path[(endPos + 1)..];
+        }
+    }
+
+    public int FindDirectory(ReadOnlySpan<char> path)
+    {
+        var node = FindNode(path);
+        return node >= 0 && IsDirectory(node) ? node : -1;
+    }
+
+    public PackagedFileInfo FindFile(ReadOnlySpan<char> path)
+    {
+        var node = FindNode(path);
+        return node >= 0 ? GetFile(node) : null;
+    }
+
+    public bool IsDirectory(int node) => Nodes[node].NumChildren > 0;
+
+    public PackagedFileInfo GetFile(int node) => Nodes[node].File >= 0 ? Files[Nodes[node].File] : null;
+
+    public string GetName(int node) => Nodes[node].Name >= 0 ? Segments[Nodes[node].Name] : "";
+
+    // Children of a node in the order they were added
+    public ReadOnlySpan<int> GetChildren(int node) => OrderedChildren.AsSpan(Nodes[node].FirstChild, Nodes[node].NumChildren);
+
+    // Path of a node relative to the root, rebuilt from the interned segments
+    public string GetPath(int node)
+    {
+        if (node == RootNode) return "";
+
+        var parent = Nodes[node].Parent;
+        return parent == RootNode ? GetName(node) : GetPath(parent) + "/" + GetName(node);
+    }
+
+    // Tree under construction; nodes and visible files are numbered in insertion order
+    private sealed class Fragment
+    {
+        private readonly SegmentPool Segments = new();
+        private readonly List<Node> Nodes = [new Node { Name = -1, Parent = -1, File = -1 }];
+        private readonly List<PackagedFileInfo> Visible = [];
+        // (parent << 32 | segment) -> node
+        private readonly Dictionary<long, int> ChildMap = [];
+
+        public void Add(PackagedFileInfo file)
+        {
+            var path = file.Name.AsSpan();
+            var node = RootNode;
+            while (true)
+            {
+                var endPos = path.IndexOf('/');
+                node = GetOrAddChild(node, Segments.Intern(endPos >= 0 ? path[..endPos] : path));
+                if (endPos < 0) break;
+                path = path[(endPos + 1)..];
+            }
+
+            SetFile(node, file);
+        }
+
+        // Adds the nodes and files of a fragment built from files listed after the ones already added
+        public void Merge(Fragment other)
+        {
+            var segmentMap = new int[other.Segments.Strings.Count];
+            for (var i = 0; i < segmentMap.Length; i++)
+            {
+                segmentMap[i] = Segments.Intern(other.Segments.Strings[i]);
+            }
+
+            // Parents are always added before their children, so one pass in node order maps every node.
+            // Children of a node created by this merge can't exist yet, so they skip the lookup.
+            var firstNew = Nodes.Count;
+            var nodeMap = new int[other.Nodes.Count];
+            var fileNodes = new int[other.Visible.Count];
+            nodeMap[RootNode] = RootNode;
+            for (var i = 1; i < nodeMap.Length; i++)
+            {
+                var node = other.Nodes[i];
+                var parent = nodeMap[node.Parent];
+                var segment = segmentMap[node.Name];
+                nodeMap[i] = parent >= firstNew ? AddChild(parent, segment) : GetOrAddChild(parent, segment);
+                if (node.File >= 0)
+                {
+                    fileNodes[node.File] = nodeMap[i];
+                }
+            }
+
+            // Visible files are merged in the order they were first seen, same as adding them one by one
+            for (var i = 0; i < fileNodes.Length; i++)
+            {
+                SetFile(fileNodes[i], other.Visible[i]);
+            }
+        }
+
+        private int GetOrAddChild(int node, int segment)
+        {
+            return ChildMap.TryGetValue(((long)node << 32) | (uint)segment, out var child) ? child : AddChild(node, segment);
+        }
+
+        private int AddChild(int node, int segment)
+        {
+            var child = Nodes.Count;
+            Nodes.Add(new Node { Name = segment, Parent = node, File = -1 });
+            ChildMap.Add(((long)node << 32) | (uint)segment, child);
+            return child;
+        }
+
+        private void SetFile(int node, PackagedFileInfo file)
+        {
+            ref var leaf = ref CollectionsMarshal.AsSpan(Nodes)[node];
+            if (leaf.File < 0)
+            {
+                leaf.File = Visible.Count;
+                Visible.Add(file);
+            }
+            else if (Visible[leaf.File].Package.Metadata.Priority < file.Package.Metadata.Priority)
+            {
+                Visible[leaf.File] = file;
+            }
+        }
+
+        public VFSPathTable ToTable()
+        {
+            var nodeArray = Nodes.ToArray();
+            var segmentHashes = Segments.Hashes.ToArray();
+            var children = BuildChildren(nodeArray, segmentHashes, out var childHashes, out var orderedChildren);
+            return new VFSPathTable(Segments.Strings.ToArray(), nodeArray, children, childHashes, orderedChildren, Visible.ToArray());
+        }
+    }
+
+    // Case-insensitive string interning keyed by spans, so lookups of existing segments don't allocate
+    private sealed class SegmentPool
+    {
+        public readonly List<string> Strings = [];
+        public readonly List<int> Hashes = [];
+        // Segment index + 1; 0 is an empty slot
+        private int[] Slots = new int[0x400];
+
+        public int Intern(ReadOnlySpan<char> s)
+        {
+            if (Strings.Count * 2 >= Slots.Length)
+            {
+                Grow();
+            }
+
+            var hash = Hash(s);
+            var mask = Slots.Length - 1;
+            var slot = hash & mask;
+            while (Slots[slot] != 0)
+            {
+                var index = Slots[slot] - 1;
+                if (Hashes[index] == hash && s.Equals(Strings[index], StringComparison.OrdinalIgnoreCase)) return index;
+                slot = (slot + 1) & mask;
+            }
+
+            Strings.Add(s.ToString());
+            Hashes.Add(hash);
+            Slots[slot] = Strings.Count;
+            return Strings.Count - 1;
+        }
+
+        private void Grow()
+        {
+            Slots = new int[Slots.Length * 2];
+            var mask = Slots.Length - 1;
+            for (var i = 0; i < Strings.Count; i++)
+            {
+                var slot = Hashes[i] & mask;
+                while (Slots[slot] != 0)
+                {
+                    slot = (slot + 1) & mask;
+                }
+                Slots[slot] = i + 1;
+            }
+        }
+    }
+}
@@ -0,0 +1,330 @@
+﻿using System.IO.Hashing;
+using System.IO.MemoryMappedFiles;
+using LSLib.LS.Enums;
+
+namespace LSLib.LS;
+
+[StructLayout(LayoutKind.Sequential, Pack = 1)]
+internal struct VFSSnapshotHeader
+{
+    public const UInt32 Signature = 0x5346564C; // "LVFS"
+    public const UInt32 CurrentVersion = 3;
+
+    public UInt32 Magic;
+    public UInt32 Version;
+    public UInt32 NumPackages;
+    public UInt32 NumFiles;
+    public UInt32 StringTableSize;
+}
+
+[StructLayout(LayoutKind.Sequential, Pack = 1)]
+internal struct VFSSnapshotPackage
+{
+    public UInt32 PathOffset;
+    public UInt32 PathLength;
+    // Validation key of the main archive file
+    public Int64 Size;
+    public Int64 LastWriteTime;
+    public UInt64 HeaderHash;
+    // Hash of the size and modification time of the _N.pak parts
+    public UInt64 PartsHash;
+    // Header fields needed to open the package without reading its file list
+    public UInt32 Version;
+    public UInt32 NumParts;
+    public UInt32 DataOffset;
+    public UInt32 Flags;
+    public Byte Priority;
+    // Compressed frame of solid packages; size is 0 if no file of the package is visible
+    public Int64 SolidOffset;
+    public Int32 SolidSize;
+}
+
+[StructLayout(LayoutKind.Sequential, Pack = 1)]
+internal struct VFSSnapshotFile
+{
+    public UInt32 NameOffset;
+    public UInt32 NameLength;
+    public UInt32 Package;
+    public UInt32 ArchivePart;
+    public UInt32 Crc;
+    public Byte Flags;
+    public Byte Solid;
+    public UInt64 OffsetInFile;
+    public UInt64 SizeOnDisk;
+    public UInt64 UncompressedSize;
+    public UInt64 SolidOffset;
+    // Key of the file in VFSPathIndex
+    public UInt64 PathHash;
+}
+
+// Cache of the merged VFS file table. Records are stored as flat struct arrays (packages, files, and the
+// path order of the files) followed by a UTF-8 string table, so a snapshot can be mapped and walked
+// without parsing any of the packages it describes, and the path index is restored without rehashing.
+// Each package is keyed by its size, modification time, a hash of its header area and the size and
+// modification time of its archive parts; if any of them changed, the snapshot is discarded and rebuilt.
+internal static class VFSSnapshot
+{
+    // Number of bytes hashed from the start and the end of the archive.
+    // Covers the header of all package versions and the tail of the file list.
+    private const int HeaderHashSize = 0x1000;
+
+    public static ulong ComputeHeaderHash(string path, long size)
+    {
+        using var handle = File.OpenHandle(path);
+        var hash = new XxHash64();
+        Span<byte> buf = stackalloc byte[HeaderHashSize];
+
+        var headSize = (int)Math.Min(HeaderHashSize, size);
+        RandomAccess.Read(handle, buf[..headSize], 0);
+        hash.Append(buf[..headSize]);
+
+        if (size > HeaderHashSize)
+        {
+            var tailOffset = Math.Max(HeaderHashSize, size - HeaderHashSize);
+            var tailSize = (int)(size - tailOffset);
+            RandomAccess.Read(handle, buf[..tailSize], tailOffset);
+            hash.Append(buf[..tailSize]);
+        }
+
+        return hash.GetCurrentHashAsUInt64();
+    }
+
+    public static ulong ComputePartsHash(string path, uint numParts)
+    {
+        var hash = new XxHash64();
+        Span<long> key = stackalloc long[2];
+        for (uint part = 1; part < numParts; part++)
+        {
+            var info = new FileInfo(Package.MakePartFilename(path, (int)part));
+            // A missing part hashes differently from any existing one
+            key[0] = info.Exists ? info.Length : -1;
+            key[1] = info.Exists ? info.LastWriteTimeUtc.Ticks : -1;
+            hash.Append(MemoryMarshal.AsBytes(key));
+        }
+
+        return hash.GetCurrentHashAsUInt64();
+    }
+
+    private static bool IsUpToDate(string path, in VFSSnapshotPackage record)
+    {
+        var info = new FileInfo(path);
+        return info.Exists
+            && info.Length == record.Size
+            && info.LastWriteTimeUtc.Ticks == record.LastWriteTime
+            && ComputeHeaderHash(path, info.Length) == record.HeaderHash
+            && ComputePartsHash(path, record.NumParts) == record.PartsHash;
+    }
+
+    public static void Save(string snapshotPath, IList<Package> packages, VFSPathIndex index)
+    {
+        var files = index.VisibleFiles;
+        var strings = new MemoryStream();
+        var packageIndices = new Dictionary<Package, int>();
+        var packageRecords = new VFSSnapshotPackage[packages.Count];
+
+        (UInt32, UInt32) AddString(string s)
+        {
+            var offset = (UInt32)strings.Position;
+            var bytes = Encoding.UTF8.GetBytes(s);
+            strings.Write(bytes);
+            return (offset, (UInt32)bytes.Length);
+        }
+
+        for (var i = 0; i < packages.Count; i++)
+        {
+            var package = packages[i];
+            var info = new FileInfo(package.PackagePath);
+            packageIndices[package] = i;
+
+            ref var record = ref packageRecords[i];
+            (record.PathOffset, record.PathLength) = AddString(Path.GetFullPath(package.PackagePath));
+            record.Size = info.Length;
+            record.LastWriteTime = info.LastWriteTimeUtc.Ticks;
+            record.HeaderHash = ComputeHeaderHash(package.PackagePath, info.Length);
+            record.Version = package.Metadata.Version;
+            record.NumParts = package.Metadata.NumParts;
+            record.PartsHash = ComputePartsHash(package.PackagePath, record.NumParts);
+            record.DataOffset = package.Metadata.DataOffset;
+            record.Flags = (UInt32)package.Metadata.Flags;
+            record.Priority = package.Metadata.Priority;
+        }
+
+        var fileRecords = new VFSSnapshotFile[files.Count];
+        for (var i = 0; i < files.Count; i++)
+        {
+            var file = files[i];
+            var packageIndex = packageIndices[file.Package];
+            var record = new VFSSnapshotFile
+            {
+                Package = (UInt32)packageIndex,
+                ArchivePart = file.ArchivePart,
+                Crc = file.Crc,
+                Flags = (Byte)file.Flags,
+                Solid = file.Solid ? (Byte)1 : (Byte)0,
+                OffsetInFile = file.OffsetInFile,
+                SizeOnDisk = file.SizeOnDisk,
+                UncompressedSize = file.UncompressedSize,
+                SolidOffset = file.SolidOffset,
+                PathHash = index.PathHashes[i]
+            };
+            (record.NameOffset, record.NameLength) = AddString(file.Name);
+            fileRecords[i] = record;
+
+            if (file.Solid)
+            {
+                packageRecords[packageIndex].SolidOffset = file.SolidSegment.Offset;
+                packageRecords[packageIndex].SolidSize = file.SolidSegment.Size;
+            }
+        }
+
+        var header = new VFSSnapshotHeader
+        {
+            Magic = VFSSnapshotHeader.Signature,
+            Version = VFSSnapshotHeader.CurrentVersion,
+            NumPackages = (UInt32)packageRecords.Length,
+            NumFiles = (UInt32)fileRecords.Length,
+            StringTableSize = (UInt32)strings.Length
+        };
+
+        // Write to a temporary file first so a concurrent reader never maps a partial snapshot
+        var tempPath = snapshotPath + ".tmp";
+        using (var f = new FileStream(tempPath, FileMode.Create, FileAccess.Write))
+        {
+            f.Write(MemoryMarshal.AsBytes(new ReadOnlySpan<VFSSnapshotHeader>(ref header)));
+            f.Write(MemoryMarshal.AsBytes(packageRecords.AsSpan()));
+            f.Write(MemoryMarshal.AsBytes(fileRecords.AsSpan()));
+            f.Write(MemoryMarshal.AsBytes(index.SortedOrder));
+            strings.Position = 0;
+            strings.CopyTo(f);
+        }
+
+        File.Move(tempPath, snapshotPath, true);
+    }
+
+    // Opens the packages described by the snapshot and returns the index of visible files.
+    // Fails if the snapshot is missing, damaged, or was made from a different list of packages.
+    public static unsafe bool TryLoad(string snapshotPath, IList<string> packagePaths, out List<Package> packages, out VFSPathIndex index)
+    {
+        packages = null;
+        index = null;
+
+        var snapshotInfo = new FileInfo(snapshotPath);
+        if (!snapshotInfo.Exists || snapshotInfo.Length < sizeof(VFSSnapshotHeader)) return false;
+
+        MemoryMappedFile mapping = null;
+        MemoryMappedViewAccessor view = null;
+        MappedPart part = null;
+        List<Package> opened = [];
+
+        try
+        {
+            mapping = MemoryMappedFile.CreateFromFile(snapshotPath, FileMode.Open, null, 0, MemoryMappedFileAccess.Read);
+            view = mapping.CreateViewAccessor(0, snapshotInfo.Length, MemoryMappedFileAccess.Read);
+            part = new MappedPart(view);
+
+            long pos = 0;
+            var header = MemoryMarshal.Read<VFSSnapshotHeader>(part.GetSpan(pos, sizeof(VFSSnapshotHeader)));
+            pos += sizeof(VFSSnapshotHeader);
+            if (header.Magic != VFSSnapshotHeader.Signature
+                || header.Version != VFSSnapshotHeader.CurrentVersion
+                || header.NumPackages != packagePaths.Count)
+            {
+                return false;
+            }
+
+            var packageRecords = MemoryMarshal.Cast<byte, VFSSnapshotPackage>(
+                part.GetSpan(pos, checked((int)header.NumPackages * sizeof(VFSSnapshotPackage))));
+            pos += packageRecords.Length * sizeof(VFSSnapshotPackage);
+            var fileRecords = MemoryMarshal.Cast<byte, VFSSnapshotFile>(
+                part.GetSpan(pos, checked((int)header.NumFiles * sizeof(VFSSnapshotFile))));
+            pos += fileRecords.Length * sizeof(VFSSnapshotFile);
+            var sortedOrder = MemoryMarshal.Cast<byte, int>(part.GetSpan(pos, checked((int)header.NumFiles * sizeof(int))));
+            pos += sortedOrder.Length * sizeof(int);
+            var strings = part.GetSpan(pos, (int)header.StringTableSize);
+
+            for (var i = 0; i < packageRecords.Length; i++)
+            {
+                ref readonly var record = ref packageRecords[i];
+                var path = Encoding.UTF8.GetString(strings.Slice((int)record.PathOffset, (int)record.PathLength));
+                if (path != Path.GetFullPath(packagePaths[i]) || !IsUpToDate(packagePaths[i], record))
+                {
+                    return false;
+                }
+            }
+
+            var segments = new SolidSegment[packageRecords.Length];
+            for (var i = 0; i < packageRecords.Length; i++)
+            {
+                ref readonly var record = ref packageRecords[i];
+                var package = new Package(packagePaths[i]);
+                opened.Add(package);
+
+                package.Metadata = new PackageHeaderCommon
+                {
+                    Version = record.Version,
+                    NumParts = record.NumParts,
+                    DataOffset = record.DataOffset,
+                    Flags = (PackageFlags)record.Flags,
+                    Priority = record.Priority
+                };
+                package.OpenStreams((int)record.NumParts);
+
+                if (record.SolidSize > 0)
+                {
+                    segments[i] = new SolidSegment(package.MetadataView, record.SolidOffset, record.SolidSize);
+                }
+            }
+
+            var result = new PackagedFileInfo[fileRecords.Length];
+            var hashes = new ulong[fileRecords.Length];
+            for (var i = 0; i < fileRecords.Length; i++)
+            {
+                ref readonly var record = ref fileRecords[i];
+                var package = opened[(int)record.Package];
+                var file = new PackagedFileInfo
+                {
+                    Package = package,
+                    PackageFile = package.Parts[record.ArchivePart],
+                    PackageView = package.Views[record.ArchivePart],
+                    PackageMapping = package.MappedParts[record.ArchivePart],
+                    Name = Encoding.UTF8.GetString(strings.Slice((int)record.NameOffset, (int)record.NameLength)),
+                    ArchivePart = record.ArchivePart,
+                    Crc = record.Crc,
+                    Flags = (CompressionFlags)record.Flags,
+                    OffsetInFile = record.OffsetInFile,
+                    SizeOnDisk = record.SizeOnDisk,
+                    UncompressedSize = record.UncompressedSize
+                };
+
+                if (record.Solid != 0)
+                {
+                    file.MakeSolid(record.SolidOffset, segments[record.Package]);
+                }
+
+                result[i] = file;
+                hashes[i] = record.PathHash;
+            }
+
+            index = VFSPathIndex.FromSnapshot(result, hashes, sortedOrder.ToArray());
+            packages = opened;
+            return true;
+        }
+        catch (Exception e) when (e is InvalidDataException || e is ArgumentOutOfRangeException
+            || e is IndexOutOfRangeException || e is OverflowException || e is IOException
+            || e is UnauthorizedAccessException)
+        {
+            // Damaged snapshot or unreadable package; rebuild from the packages instead
+            return false;
+        }
+        finally
+        {
+            part?.Dispose();
+            view?.Dispose();
+            mapping?.Dispose();
+            if (index == null)
+            {
+                opened.ForEach(p => p.Dispose());
+            }
+        }
+    }
+}
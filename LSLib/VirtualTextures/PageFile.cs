@@ -18,7 +18,7 @@ public class PageFile : IDisposable
         Stream = new FileStream(path, FileMode.Open, FileAccess.Read);
         Reader = new BinaryReader(Stream);
 
-        Header = BinUtils.ReadStruct<GTPHeader>(Reader);
+        BinUtils.ReadStruct(Reader, out Header);
 
         var numPages = Stream.Length / tileset.Header.PageSize;
         ChunkOffsets = [];
@@ -27,7 +27,7 @@ public class PageFile : IDisposable
         {
             var numOffsets = Reader.ReadUInt32();
             var offsets = new UInt32[numOffsets];
-            BinUtils.ReadStructs<UInt32>(Reader, offsets);
+            BinUtils.ReadStructs(Reader, offsets.AsSpan());
             ChunkOffsets.Add(offsets);
 
             Stream.Position = (page + 1) * tileset.Header.PageSize;
@@ -84,7 +84,7 @@ public class PageFile : IDisposable
     public byte[] UnpackTile(int pageIndex, int chunkIndex, int outputSize, TileCompressor compressor)
     {
         Stream.Position = ChunkOffsets[pageIndex][chunkIndex] + (pageIndex * TileSet.Header.PageSize);
-        var chunkHeader = BinUtils.ReadStruct<GTPChunkHeader>(Reader);
+        BinUtils.ReadStruct(Reader, out GTPChunkHeader chunkHeader);
         return chunkHeader.Codec switch
         {
             GTSCodec.Uniform => DoUnpackTileUniform(chunkHeader),
@@ -160,7 +160,7 @@ public class PageFileBuilder(TileSetConfiguration config)
             ParameterBlockID = chunk.ParameterBlockID,
             Size = (UInt32)chunk.EncodedBlob.Length
         };
-        BinUtils.WriteStruct<GTPChunkHeader>(writer, ref header);
+        BinUtils.WriteStruct(writer, header);
         writer.Write(chunk.EncodedBlob);
     }
 
@@ -172,7 +172,7 @@ public class PageFileBuilder(TileSetConfiguration config)
             Version = GTPHeader.DefaultVersion,
             GUID = Checksum
         };
-        BinUtils.WriteStruct<GTPHeader>(writer, ref header);
+        BinUtils.WriteStruct(writer, header);
 
         for (var i = 0; i < Pages.Count; i++)
         {
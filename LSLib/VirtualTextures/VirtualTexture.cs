@@ -109,7 +109,7 @@ public class TileSetFourCC
         while (fs.Position < end)
         {
             var cc = new FourCCElement();
-            var header = BinUtils.ReadStruct<GTSFourCCMetadata>(reader);
+            BinUtils.ReadStruct(reader, out GTSFourCCMetadata header);
             cc.FourCC = header.FourCCName;
 
             Int32 valueSize = header.Length;
@@ -234,7 +234,7 @@ public class TileSetFourCC
             header.ExtendedLength = 1;
         }
 
-        BinUtils.WriteStruct<GTSFourCCMetadata>(writer, ref header);
+        BinUtils.WriteStruct(writer, header);
 
         if (length > 0xffff)
         {
@@ -342,9 +342,9 @@ public class VirtualTileSet : IDisposable
     private void LoadThumbnails(Stream fs, BinaryReader reader)
     {
         fs.Position = (long)Header.ThumbnailsOffset;
-        var thumbHdr = BinUtils.ReadStruct<GTSThumbnailInfoHeader>(reader);
+        BinUtils.ReadStruct(reader, out GTSThumbnailInfoHeader thumbHdr);
         ThumbnailInfos = new GTSThumbnailInfo[thumbHdr.NumThumbnails];
-        BinUtils.ReadStructs<GTSThumbnailInfo>(reader, ThumbnailInfos);
+        BinUtils.ReadStructs(reader, ThumbnailInfos.AsSpan());
 
         foreach (var thumb in ThumbnailInfos)
         {
@@ -380,28 +380,28 @@ public class VirtualTileSet : IDisposable
 
     public void LoadFromStream(Stream fs, BinaryReader reader, bool loadThumbnails)
     {
-        Header = BinUtils.ReadStruct<GTSHeader>(reader);
+        BinUtils.ReadStruct(reader, out Header);
 
         fs.Position = (uint)Header.LayersOffset;
         TileSetLayers = new GTSTileSetLayer[Header.NumLayers];
-        BinUtils.ReadStructs<GTSTileSetLayer>(reader, TileSetLayers);
+        BinUtils.ReadStructs(reader, TileSetLayers.AsSpan());
 
         fs.Position = (uint)Header.LevelsOffset;
         TileSetLevels = new GTSTileSetLevel[Header.NumLevels];
-        BinUtils.ReadStructs<GTSTileSetLevel>(reader, TileSetLevels);
+        BinUtils.ReadStructs(reader, TileSetLevels.AsSpan());
 
         PerLevelFlatTileIndices = [];
         foreach (var level in TileSetLevels)
         {
             fs.Position = (uint)level.FlatTileIndicesOffset;
             var tileIndices = new UInt32[level.Height * level.Width * Header.NumLayers];
-            BinUtils.ReadStructs<UInt32>(reader, tileIndices);
+            BinUtils.ReadStructs(reader, tileIndices.AsSpan());
             PerLevelFlatTileIndices.Add(tileIndices);
         }
 
         fs.Position = (uint)Header.ParameterBlockHeadersOffset;
         ParameterBlockHeaders = new GTSParameterBlockHeader[Header.ParameterBlockHeadersCount];
-        BinUtils.ReadStructs<GTSParameterBlockHeader>(reader, ParameterBlockHeaders);
+        BinUtils.ReadStructs(reader, ParameterBlockHeaders.AsSpan());
 
         ParameterBlocks = [];
         foreach (var hdr in ParameterBlockHeaders)
@@ -431,7 +431,7 @@ public class VirtualTileSet : IDisposable
                 Debug.Assert(hdr.Codec == GTSCodec.Uniform);
                 Debug.Assert(hdr.ParameterBlockSize == 0x10);
 
-                var blk = BinUtils.ReadStruct<GTSUniformParameterBlock>(reader);
+                BinUtils.ReadStruct(reader, out GTSUniformParameterBlock blk);
                 Debug.Assert(blk.Version == 0x42);
                 Debug.Assert(blk.A_Unused == 0);
                 Debug.Assert(blk.Width == 4);
@@ -469,20 +469,20 @@ public class VirtualTileSet : IDisposable
 
         fs.Position = (long)Header.PackedTileIDsOffset;
         PackedTileIDs = new GTSPackedTileID[Header.NumPackedTileIDs];
-        BinUtils.ReadStructs<GTSPackedTileID>(reader, PackedTileIDs);
+        BinUtils.ReadStructs(reader, PackedTileIDs.AsSpan());
 
         fs.Position = (long)Header.FlatTileInfoOffset;
         FlatTileInfos = new GTSFlatTileInfo[Header.NumFlatTileInfos];
-        BinUtils.ReadStructs<GTSFlatTileInfo>(reader, FlatTileInfos);
+        BinUtils.ReadStructs(reader, FlatTileInfos.AsSpan());
     }
 
     public void SaveToStream(Stream fs, BinaryWriter writer)
     {
-        BinUtils.WriteStruct<GTSHeader>(writer, ref Header);
+        BinUtils.WriteStruct(writer, Header);
 
         Header.LayersOffset = (ulong)fs.Position;
         Header.NumLayers = (uint)TileSetLayers.Length;
-        BinUtils.WriteStructs<GTSTileSetLayer>(writer, TileSetLayers);
+        BinUtils.WriteStructs<GTSTileSetLayer>(writer, TileSetLayers.AsSpan());
 
         for (var i = 0; i < TileSetLevels.Length; i++)
         {
@@ -492,16 +492,16 @@ public class VirtualTileSet : IDisposable
             var tileIndices = PerLevelFlatTileIndices[i];
             Debug.Assert(tileIndices.Length == level.Height * level.Width * Header.NumLayers);
 
-            BinUtils.WriteStructs<UInt32>(writer, tileIndices);
+            BinUtils.WriteStructs<UInt32>(writer, tileIndices.AsSpan());
         }
 
         Header.LevelsOffset = (ulong)fs.Position;
         Header.NumLevels = (uint)TileSetLevels.Length;
-        BinUtils.WriteStructs<GTSTileSetLevel>(writer, TileSetLevels);
+        BinUtils.WriteStructs<GTSTileSetLevel>(writer, TileSetLevels.AsSpan());
 
         Header.ParameterBlockHeadersOffset = (ulong)fs.Position;
         Header.ParameterBlockHeadersCount = (uint)ParameterBlockHeaders.Length;
-        BinUtils.WriteStructs<GTSParameterBlockHeader>(writer, ParameterBlockHeaders);
+        BinUtils.WriteStructs<GTSParameterBlockHeader>(writer, ParameterBlockHeaders.AsSpan());
 
         for (var i = 0; i < ParameterBlockHeaders.Length; i++)
         {
@@ -519,7 +519,7 @@ public class VirtualTileSet : IDisposable
                 hdr.ParameterBlockSize = 0x10;
 
                 var block = (GTSUniformParameterBlock)ParameterBlocks[hdr.ParameterBlockID];
-                BinUtils.WriteStruct<GTSUniformParameterBlock>(writer, ref block);
+                BinUtils.WriteStruct(writer, block);
             }
         }
 
@@ -541,22 +541,22 @@ public class VirtualTileSet : IDisposable
         {
             NumThumbnails = 0
         };
-        BinUtils.WriteStruct<GTSThumbnailInfoHeader>(writer, ref thumbHdr);
+        BinUtils.WriteStruct(writer, thumbHdr);
 
         Header.PackedTileIDsOffset = (ulong)fs.Position;
         Header.NumPackedTileIDs = (uint)PackedTileIDs.Length;
-        BinUtils.WriteStructs<GTSPackedTileID>(writer, PackedTileIDs);
+        BinUtils.WriteStructs<GTSPackedTileID>(writer, PackedTileIDs.AsSpan());
 
         Header.FlatTileInfoOffset = (ulong)fs.Position;
         Header.NumFlatTileInfos = (uint)FlatTileInfos.Length;
-        BinUtils.WriteStructs<GTSFlatTileInfo>(writer, FlatTileInfos);
+        BinUtils.WriteStructs<GTSFlatTileInfo>(writer, FlatTileInfos.AsSpan());
 
         // Re-write structures that contain offset information
         fs.Position = 0;
-        BinUtils.WriteStruct<GTSHeader>(writer, ref Header);
+        BinUtils.WriteStruct(writer, Header);
 
         fs.Position = (long)Header.ParameterBlockHeadersOffset;
-        BinUtils.WriteStructs<GTSParameterBlockHeader>(writer, ParameterBlockHeaders);
+        BinUtils.WriteStructs<GTSParameterBlockHeader>(writer, ParameterBlockHeaders.AsSpan());
     }
 
     public bool GetTileInfo(int level, int layer, int x, int y, ref GTSFlatTileInfo tile)
@@ -0,0 +1,95 @@
+﻿using System.Diagnostics;
+using System.Runtime.InteropServices;
+using LSLib.LS;
+using LSLib.VirtualTextures;
+
+namespace LSLib.Bench;
+
+// Compares the marshalling struct I/O path of BinUtils with the span-based path for unmanaged types,
+// using the tile tables of a GTS file as the workload.
+// Usage: LSLibBench [number of elements] [iterations]
+internal class Program
+{
+    private static double Measure(string name, int iterations, long bytes, Action action)
+    {
+        // Warm up JIT and caches
+        action();
+
+        var sw = Stopwatch.StartNew();
+        for (var i = 0; i < iterations; i++)
+        {
+            action();
+        }
+        sw.Stop();
+
+        var seconds = sw.Elapsed.TotalSeconds;
+        Console.WriteLine($"{name,-40} {seconds * 1000.0 / iterations,10:0.000} ms/iter {bytes * iterations / seconds / (1024 * 1024),10:0.0} MB/s");
+        return seconds;
+    }
+
+    private static void Compare<T>(string name, T[] elements, int iterations) where T : unmanaged
+    {
+        var stream = new MemoryStream();
+        var writer = new BinaryWriter(stream);
+        var reader = new BinaryReader(stream);
+        var bytes = (long)elements.Length * Marshal.SizeOf<T>();
+        var readBack = new T[elements.Length];
+
+        var oldWrite = Measure($"{name} WriteStructs (marshal)", iterations, bytes, () =>
+        {
+            stream.Position = 0;
+            BinUtils.WriteStructs<T>(writer, elements);
+        });
+        var newWrite = Measure($"{name} WriteStructs (span)", iterations, bytes, () =>
+        {
+            stream.Position = 0;
+            BinUtils.WriteStructs<T>(writer, elements.AsSpan());
+        });
+
+        var oldRead = Measure($"{name} ReadStructs (marshal)", iterations, bytes, () =>
+        {
+            stream.Position = 0;
+            BinUtils.ReadStructs<T>(reader, readBack);
+        });
+        var newRead = Measure($"{name} ReadStructs (span)", iterations, bytes, () =>
+        {
+            stream.Position = 0;
+            BinUtils.ReadStructs(reader, readBack.AsSpan());
+        });
+
+        if (!MemoryMarshal.AsBytes(elements.AsSpan()).SequenceEqual(MemoryMarshal.AsBytes(readBack.AsSpan())))
+        {
+            throw new InvalidDataException($"{name}: data read back doesn't match");
+        }
+
+        Console.WriteLine($"{name}: write {oldWrite / newWrite:0.0}x, read {oldRead / newRead:0.0}x faster");
+        Console.WriteLine();
+    }
+
+    static void Main(string[] args)
+    {
+        var count = args.Length > 0 ? Int32.Parse(args[0]) : 1 << 20;
+        var iterations = args.Length > 1 ? Int32.Parse(args[1]) : 20;
+        var rng = new Random(1);
+
+        var tileIds = new GTSPackedTileID[count];
+        var tileInfos = new GTSFlatTileInfo[count];
+        for (var i = 0; i < count; i++)
+        {
+            tileIds[i] = new GTSPackedTileID((uint)rng.Next(16), (uint)rng.Next(16), (uint)rng.Next(4096), (uint)rng.Next(4096));
+            tileInfos[i] = new GTSFlatTileInfo
+            {
+                PageFileIndex = (UInt16)rng.Next(0x10000),
+                PageIndex = (UInt16)rng.Next(0x10000),
+                ChunkIndex = (UInt16)rng.Next(0x10000),
+                D = 1,
+                PackedTileIndex = (UInt32)i
+            };
+        }
+
+        Console.WriteLine($"{count} elements, {iterations} iterations");
+        Console.WriteLine();
+        Compare("GTSPackedTileID", tileIds, iterations);
+        Compare("GTSFlatTileInfo", tileInfos, iterations);
+    }
+}
@@ -0,0 +1,219 @@
+#include "crc32.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CRC32_X64
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(__GNUC__)
+#define CRC32_TARGET_CLMUL __attribute__((target("sse4.1,pclmul")))
+#else
+#define CRC32_TARGET_CLMUL
+#endif
+
+/* Slicing-by-8 tables, built on first use */
+static uint32_t crc32_table[8][256];
+static volatile int crc32_table_ready = 0;
+
+static void crc32_init_tables(void)
+{
+	uint32_t i, j, c;
+
+	for (i = 0; i < 256; i++) {
+		c = i;
+		for (j = 0; j < 8; j++) {
+			c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : (c >> 1);
+		}
+		crc32_table[0][i] = c;
+	}
+
+	for (i = 0; i < 256; i++) {
+		c = crc32_table[0][i];
+		for (j = 1; j < 8; j++) {
+			c = crc32_table[0][c & 0xff] ^ (c >> 8);
+			crc32_table[j][i] = c;
+		}
+	}
+
+	/* Concurrent initialization is harmless; every thread writes the same values */
+	crc32_table_ready = 1;
+}
+
+static uint32_t crc32_scalar(uint32_t crc, const uint8_t* buf, size_t len)
+{
+	if (!crc32_table_ready) {
+		crc32_init_tables();
+	}
+
+	while (len > 0 && ((uintptr_t)buf & 7) != 0) {
+		crc = crc32_table[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+		len--;
+	}
+
+	while (len >= 8) {
+		uint32_t lo = crc ^ ((uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24));
+		uint32_t hi = (uint32_t)buf[4] | ((uint32_t)buf[5] << 8) | ((uint32_t)buf[6] << 16) | ((uint32_t)buf[7] << 24);
+		crc = crc32_table[7][lo & 0xff] ^ crc32_table[6][(lo >> 8) & 0xff]
+			^ crc32_table[5][(lo >> 16) & 0xff] ^ crc32_table[4][lo >> 24]
+			^ crc32_table[3][hi & 0xff] ^ crc32_table[2][(hi >> 8) & 0xff]
+			^ crc32_table[1][(hi >> 16) & 0xff] ^ crc32_table[0][hi >> 24];
+		buf += 8;
+		len -= 8;
+	}
+
+	while (len > 0) {
+		crc = crc32_table[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+		len--;
+	}
+
+	return crc;
+}
+
+#if defined(CRC32_X64)
+
+/*
+ * Folding with carry-less multiplication, as described in "Fast CRC Computation for
+ * Generic Polynomials Using PCLMULQDQ Instruction" (Intel, 2009). The SSE4.2 crc32
+ * instruction implements CRC-32C and can't be used for the IEEE polynomial.
+ * Requires len >= 64 and a multiple of 16; crc is the inverted running value.
+ */
+CRC32_TARGET_CLMUL
+static uint32_t crc32_clmul(uint32_t crc, const uint8_t* buf, size_t len)
+{
+	const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+	const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+	const __m128i k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+	const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+	const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+	x1 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+	x2 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+	x3 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+	x4 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+	buf += 64;
+	len -= 64;
+
+	/* Fold four 128-bit lanes in parallel */
+	x0 = k1k2;
+	while (len >= 64) {
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(buf + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(buf + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(buf + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(buf + 0x30)));
+
+		buf += 64;
+		len -= 64;
+	}
+
+	/* Fold the lanes into a single 128-bit value */
+	x0 = k3k4;
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	while (len >= 16) {
+		x2 = _mm_loadu_si128((const __m128i*)buf);
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+		buf += 16;
+		len -= 16;
+	}
+
+	/* Fold 128 bits to 64 bits */
+	x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask32);
+	x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	/* Barrett reduction to 32 bits */
+	x2 = _mm_and_si128(x1, mask32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+	x2 = _mm_and_si128(x2, mask32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+static int crc32_detect_clmul(void)
+{
+	unsigned int ecx;
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	ecx = (unsigned int)info[2];
+#else
+	unsigned int eax, ebx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return 0;
+#endif
+	/* PCLMULQDQ (bit 1) and SSE4.1 (bit 19) */
+	return (ecx & (1u << 1)) && (ecx & (1u << 19));
+}
+
+/* -1 = not detected yet */
+static volatile int crc32_has_clmul = -1;
+
+int lslib_crc32_accelerated(void)
+{
+	if (crc32_has_clmul < 0) {
+		crc32_has_clmul = crc32_detect_clmul();
+	}
+
+	return crc32_has_clmul;
+}
+
+#else
+
+int lslib_crc32_accelerated(void)
+{
+	return 0;
+}
+
+#endif
+
+uint32_t lslib_crc32(uint32_t crc, const uint8_t* buf, size_t len)
+{
+	crc = ~crc;
+
+#if defined(CRC32_X64)
+	if (len >= 64 && lslib_crc32_accelerated()) {
+		size_t blocks = len & ~(size_t)15;
+		crc = crc32_clmul(crc, buf, blocks);
+		buf += blocks;
+		len -= blocks;
+	}
+#endif
+
+	return ~crc32_scalar(crc, buf, len);
+}
@@ -0,0 +1,22 @@
+#ifndef LSLIB_CRC32_H
+#define LSLIB_CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* CRC-32 (IEEE 802.3, reflected), compatible with zlib and System.IO.Hashing.Crc32.
+   Pass 0 as the initial crc; the result of a previous call continues the checksum. */
+uint32_t lslib_crc32(uint32_t crc, const uint8_t* buf, size_t len);
+
+/* Nonzero if the PCLMULQDQ folding implementation is used on this CPU */
+int lslib_crc32_accelerated(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "crc32wrapper.h"
+
+namespace LSLib {
+	namespace Native {
+		UInt32 Crc32::Compute(array<byte> ^ data, int offset, int count)
+		{
+			if (offset < 0 || count < 0 || offset + (Int64)count > data->Length)
+			{
+				throw gcnew ArgumentOutOfRangeException("count");
+			}
+
+			if (count == 0)
+			{
+				return 0;
+			}
+
+			pin_ptr<byte> dataPin(&data[offset]);
+			return lslib_crc32(0, dataPin, count);
+		}
+
+		UInt32 Crc32::Compute(IntPtr data, Int64 length)
+		{
+			return lslib_crc32(0, (uint8_t const *)data.ToPointer(), (size_t)length);
+		}
+
+		bool Crc32::IsAccelerated::get()
+		{
+			return lslib_crc32_accelerated() != 0;
+		}
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#pragma managed(push, off)
+#include "crc32.h"
+#pragma managed(pop)
+
+using namespace System;
+
+namespace LSLib {
+	namespace Native {
+		public ref class Crc32 abstract sealed
+		{
+		public:
+			static UInt32 Compute(array<byte> ^ data, int offset, int count);
+			static UInt32 Compute(IntPtr data, Int64 length);
+
+			static property bool IsAccelerated
+			{
+				bool get();
+			}
+		};
+	}
+}
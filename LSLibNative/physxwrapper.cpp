@@ -0,0 +1,160 @@
+#include <Windows.h>
+#include <cstdint>
+#include "physxwrapper.h"
+
+namespace LSLib {
+	namespace Native {
+		typedef int(*PhysicsToolInitProc)();
+		typedef int(*PhysicsToolConvertWithRefsProc)(uint8_t const* input, size_t inputSize, int inputFormat, int outputFormat, void * externalRefs, uint8_t ** output, size_t * outputSize);
+		typedef void(*PhysicsToolFreeProc)(uint8_t * buffer);
+		typedef char const *(*PhysicsToolGetLastErrorProc)();
+		typedef void *(*PhysicsToolLoadExternalRefsProc)(uint8_t const* input, size_t inputSize);
+		typedef void(*PhysicsToolReleaseExternalRefsProc)(void * refs);
+
+		static HMODULE shPhysicsTool = NULL;
+		static PhysicsToolConvertWithRefsProc sConvertProc = NULL;
+		static PhysicsToolFreeProc sFreeProc = NULL;
+		static PhysicsToolGetLastErrorProc sGetLastErrorProc = NULL;
+		static PhysicsToolLoadExternalRefsProc sLoadExternalRefsProc = NULL;
+		static PhysicsToolReleaseExternalRefsProc sReleaseExternalRefsProc = NULL;
+
+		// Unloads a library that failed to initialize, so the next call can try again
+		static void UnloadPhysicsTool(HMODULE physicsTool)
+		{
+			sConvertProc = NULL;
+			sFreeProc = NULL;
+			sGetLastErrorProc = NULL;
+			sLoadExternalRefsProc = NULL;
+			sReleaseExternalRefsProc = NULL;
+			FreeLibrary(physicsTool);
+		}
+
+		void PhysicsConverter::LoadPhysicsTool()
+		{
+			if (shPhysicsTool) {
+				return;
+			}
+
+			auto physicsTool = LoadLibraryA("PhysicsToolLib.dll");
+			if (!physicsTool) {
+				throw gcnew System::IO::InvalidDataException("PhysicsToolLib.dll is required for converting physics resources.");
+			}
+
+			auto initProc = (PhysicsToolInitProc)GetProcAddress(physicsTool, "PhysicsToolInit");
+			sConvertProc = (PhysicsToolConvertWithRefsProc)GetProcAddress(physicsTool, "PhysicsToolConvertWithRefs");
+			sFreeProc = (PhysicsToolFreeProc)GetProcAddress(physicsTool, "PhysicsToolFree");
+			sGetLastErrorProc = (PhysicsToolGetLastErrorProc)GetProcAddress(physicsTool, "PhysicsToolGetLastError");
+			sLoadExternalRefsProc = (PhysicsToolLoadExternalRefsProc)GetProcAddress(physicsTool, "PhysicsToolLoadExternalRefs");
+			sReleaseExternalRefsProc = (PhysicsToolReleaseExternalRefsProc)GetProcAddress(physicsTool, "PhysicsToolReleaseExternalRefs");
+			if (!initProc || !sConvertProc || !sFreeProc || !sGetLastErrorProc || !sLoadExternalRefsProc || !sReleaseExternalRefsProc)
+			{
+				UnloadPhysicsTool(physicsTool);
+				throw gcnew System::IO::InvalidDataException("PhysicsToolLib.dll is missing required exports.");
+			}
+
+			// The runtime stays initialized for the lifetime of the process
+			if (!initProc())
+			{
+				// Copy the message before the library that owns it is unloaded
+				auto error = gcnew String(sGetLastErrorProc());
+				UnloadPhysicsTool(physicsTool);
+				throw gcnew System::IO::InvalidDataException(error);
+			}
+
+			shPhysicsTool = physicsTool;
+		}
+
+		static void EnsurePhysicsToolLoaded()
+		{
+			System::Threading::Monitor::Enter(PhysicsConverter::typeid);
+			try
+			{
+				PhysicsConverter::LoadPhysicsTool();
+			}
+			finally
+			{
+				System::Threading::Monitor::Exit(PhysicsConverter::typeid);
+			}
+		}
+
+		PhysicsExternalRefs::PhysicsExternalRefs(array<byte> ^ binary)
+		{
+			if (binary == nullptr || binary->Length == 0)
+			{
+				throw gcnew System::IO::InvalidDataException("External physics reference collection is empty.");
+			}
+
+			EnsurePhysicsToolLoaded();
+
+			pin_ptr<byte> inputPin(&binary[binary->GetLowerBound(0)]);
+			Handle = sLoadExternalRefsProc(inputPin, binary->Length);
+			if (!Handle)
+			{
+				throw gcnew System::IO::InvalidDataException("Failed to load external physics references: " + gcnew String(sGetLastErrorProc()));
+			}
+		}
+
+		PhysicsExternalRefs::~PhysicsExternalRefs()
+		{
+			this->!PhysicsExternalRefs();
+		}
+
+		PhysicsExternalRefs::!PhysicsExternalRefs()
+		{
+			if (Handle)
+			{
+				sReleaseExternalRefsProc(Handle);
+				Handle = nullptr;
+			}
+		}
+
+		array<byte> ^ PhysicsConverter::Convert(array<byte> ^ input, PhysicsFormat inputFormat, PhysicsFormat outputFormat)
+		{
+			return Convert(input, inputFormat, outputFormat, nullptr);
+		}
+
+		array<byte> ^ PhysicsConverter::Convert(array<byte> ^ input, PhysicsFormat inputFormat, PhysicsFormat outputFormat, PhysicsExternalRefs ^ externalRefs)
+		{
+			// Pinning the first element of an empty array throws IndexOutOfRangeException
+			if (input == nullptr || input->Length == 0)
+			{
+				throw gcnew System::IO::InvalidDataException("Cannot convert an empty physics resource.");
+			}
+
+			EnsurePhysicsToolLoaded();
+
+			void * refs = nullptr;
+			if (externalRefs != nullptr)
+			{
+				if (!externalRefs->Handle)
+				{
+					throw gcnew System::ObjectDisposedException("PhysicsExternalRefs");
+				}
+
+				refs = externalRefs->Handle;
+			}
+
+			pin_ptr<byte> inputPin(&input[input->GetLowerBound(0)]);
+			byte * in = inputPin;
+
+			uint8_t * output = nullptr;
+			size_t outputSize = 0;
+			if (!sConvertProc(in, input->Length, (int)inputFormat, (int)outputFormat, refs, &output, &outputSize))
+			{
+				throw gcnew System::IO::InvalidDataException("Failed to convert physics resource: " + gcnew String(sGetLastErrorProc()));
+			}
+
+			array<byte> ^ converted = gcnew array<byte>((int)outputSize);
+			if (outputSize > 0)
+			{
+				pin_ptr<byte> convertedPin(&converted[converted->GetLowerBound(0)]);
+				memcpy(convertedPin, output, outputSize);
+			}
+
+			sFreeProc(output);
+			// The finalizer must not release the references while the conversion is using them
+			GC::KeepAlive(externalRefs);
+			return converted;
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <msclr/marshal_cppstd.h>
+
+using namespace System;
+using namespace System::Collections::Generic;
+
+namespace LSLib {
+	namespace Native {
+		public enum class PhysicsFormat
+		{
+			Binary = 0,
+			Xml = 1
+		};
+
+		// Binary collection that other binary collections were serialized against
+		// (e.g. shared materials); must stay alive while conversions use it
+		public ref class PhysicsExternalRefs sealed
+		{
+		public:
+			PhysicsExternalRefs(array<byte> ^ binary);
+			~PhysicsExternalRefs();
+			!PhysicsExternalRefs();
+
+		internal:
+			void * Handle;
+		};
+
+		public ref class PhysicsConverter abstract sealed
+		{
+		public:
+			static array<byte> ^ Convert(array<byte> ^ input, PhysicsFormat inputFormat, PhysicsFormat outputFormat);
+			// Binary inputs may reference objects of externalRefs; binary outputs keep referencing them,
+			// XML outputs are self-contained
+			static array<byte> ^ Convert(array<byte> ^ input, PhysicsFormat inputFormat, PhysicsFormat outputFormat, PhysicsExternalRefs ^ externalRefs);
+			static void LoadPhysicsTool();
+		};
+	}
+}
@@ -0,0 +1,532 @@
+#include "PhysicsTool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <random>
+#include <sstream>
+
+#if defined(_WIN32)
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Generates synthetic collections and measures the throughput of each conversion phase.
+// Results are written as JSON to stdout, or to the file passed with --output.
+// Before measuring, the collection is round-tripped through a shared material collection;
+// the benchmark fails if the outputs don't survive it.
+
+struct BenchConfig
+{
+    uint32_t Bodies{ 1000 };
+    uint32_t Joints{ 1000 };
+    uint32_t Articulations{ 8 };
+    uint32_t ArticulationDepth{ 32 };
+    uint32_t Meshes{ 16 };
+    uint32_t MeshVertices{ 4096 };
+    uint32_t Iterations{ 5 };
+    std::string OutputPath;
+};
+
+struct PhaseResult
+{
+    std::string Name;
+    std::vector<double> Times;
+    uint64_t Bytes{ 0 };
+    uint64_t Objects{ 0 };
+};
+
+
+uint64_t GetPeakRss()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    // ru_maxrss is reported in kilobytes on Linux
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+
+double TimeMs(std::function<void()> const& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+
+std::vector<MeshCookJob> MakeMeshJobs(BenchConfig const& config, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<MeshCookJob> jobs;
+
+    for (uint32_t i = 0; i < config.Meshes; i++) {
+        MeshCookJob job;
+        if (i % 2 == 0) {
+            // Random point cloud on a sphere; the hull is limited to 255 vertices during cooking
+            job.Type = CookedMeshType::Convex;
+            for (uint32_t v = 0; v < config.MeshVertices; v++) {
+                PxVec3 p(dist(rng), dist(rng), dist(rng));
+                job.Vertices.push_back(p.getNormalized() * (1.0f + i * 0.01f));
+            }
+        } else {
+            // Height field-like grid
+            job.Type = CookedMeshType::Triangle;
+            auto side = std::max(2u, (uint32_t)std::sqrt((double)config.MeshVertices));
+            for (uint32_t y = 0; y < side; y++) {
+                for (uint32_t x = 0; x < side; x++) {
+                    job.Vertices.push_back(PxVec3((float)x, dist(rng) * 0.25f, (float)y));
+                }
+            }
+
+            for (uint32_t y = 0; y + 1 < side; y++) {
+                for (uint32_t x = 0; x + 1 < side; x++) {
+                    auto i0 = y * side + x;
+                    job.Indices.insert(job.Indices.end(), { i0, i0 + side, i0 + 1, i0 + 1, i0 + side, i0 + side + 1 });
+                }
+            }
+        }
+
+        jobs.push_back(std::move(job));
+    }
+
+    return jobs;
+}
+
+
+uint64_t MeshInputBytes(std::vector<MeshCookJob> const& jobs)
+{
+    uint64_t bytes = 0;
+    for (auto const& job : jobs) {
+        bytes += job.Vertices.size() * sizeof(PxVec3) + job.Indices.size() * sizeof(PxU32);
+    }
+
+    return bytes;
+}
+
+
+void ReleaseMeshes(std::vector<MeshCookJob>& jobs)
+{
+    for (auto& job : jobs) {
+        if (job.ConvexMesh) job.ConvexMesh->release();
+        if (job.TriangleMesh) job.TriangleMesh->release();
+        job.ConvexMesh = nullptr;
+        job.TriangleMesh = nullptr;
+        job.Cooked.clear();
+    }
+}
+
+
+class CollectionBuilder
+{
+public:
+    CollectionBuilder(PhysXConverter& converter, BenchConfig const& config)
+        : converter_(converter), config_(config), physics_(PxGetPhysics()), rng_(1234)
+    {}
+
+    PxCollection* Build()
+    {
+        collection_ = PxCreateCollection();
+
+        material_ = physics_.createMaterial(0.5f, 0.4f, 0.1f);
+        collection_->add(*material_);
+
+        meshes_ = MakeMeshJobs(config_, rng_);
+        converter_.CookMeshes(meshes_);
+        for (auto& mesh : meshes_) {
+            if (mesh.ConvexMesh) collection_->add(*mesh.ConvexMesh);
+            if (mesh.TriangleMesh) collection_->add(*mesh.TriangleMesh);
+        }
+
+        BuildBodies();
+        BuildStatics();
+        BuildJoints();
+        BuildArticulations();
+        return collection_;
+    }
+
+private:
+    PhysXConverter& converter_;
+    BenchConfig const& config_;
+    PxPhysics& physics_;
+    std::mt19937 rng_;
+    PxCollection* collection_{ nullptr };
+    PxMaterial* material_{ nullptr };
+    std::vector<MeshCookJob> meshes_;
+    std::vector<PxRigidDynamic*> bodies_;
+    // Actors and joints are resolved by name when loading XML, so names must be unique
+    std::deque<std::string> names_;
+
+    char const* MakeName(char const* prefix, uint32_t index)
+    {
+        names_.push_back(std::string(prefix) + std::to_string(index));
+        return names_.back().c_str();
+    }
+
+    PxConvexMesh* PickConvexMesh(uint32_t index)
+    {
+        for (uint32_t i = 0; i < meshes_.size(); i++) {
+            auto& mesh = meshes_[(index + i) % meshes_.size()];
+            if (mesh.ConvexMesh) return mesh.ConvexMesh;
+        }
+
+        return nullptr;
+    }
+
+    void AddShape(PxRigidActor& actor, PxGeometry const& geometry, uint32_t index)
+    {
+        auto shape = PxRigidActorExt::createExclusiveShape(actor, geometry, *material_);
+        shape->setName(MakeName("Shape_", index));
+        shape->setLocalPose(PxTransform(PxVec3(0.0f, 0.1f, 0.0f)));
+        collection_->add(*shape);
+    }
+
+    void AddBodyShape(PxRigidActor& actor, uint32_t index)
+    {
+        auto convex = PickConvexMesh(index);
+        switch (index % 4) {
+        case 0: AddShape(actor, PxBoxGeometry(0.5f, 0.25f, 1.0f), index); break;
+        case 1: AddShape(actor, PxSphereGeometry(0.75f), index); break;
+        case 2: AddShape(actor, PxCapsuleGeometry(0.3f, 0.6f), index); break;
+        case 3:
+            if (convex) {
+                AddShape(actor, PxConvexMeshGeometry(convex, PxMeshScale(0.5f)), index);
+            } else {
+                AddShape(actor, PxBoxGeometry(0.5f, 0.5f, 0.5f), index);
+            }
+            break;
+        }
+    }
+
+    void BuildBodies()
+    {
+        for (uint32_t i = 0; i < config_.Bodies; i++) {
+            auto body = physics_.createRigidDynamic(PxTransform(PxVec3((float)(i % 100) * 3.0f, 0.0f, (float)(i / 100) * 3.0f)));
+            body->setName(MakeName("Body_", i));
+            AddBodyShape(*body, i);
+            PxRigidBodyExt::updateMassAndInertia(*body, 1.0f + (i % 7));
+            body->setLinearDamping(0.05f);
+            body->setAngularDamping(0.1f);
+
+            collection_->add(*body);
+            bodies_.push_back(body);
+        }
+    }
+
+    void BuildStatics()
+    {
+        uint32_t index = 0;
+        for (auto& mesh : meshes_) {
+            if (!mesh.TriangleMesh) continue;
+
+            auto actor = physics_.createRigidStatic(PxTransform(PxVec3(0.0f, -10.0f * (index + 1), 0.0f)));
+            actor->setName(MakeName("Static_", index));
+            AddShape(*actor, PxTriangleMeshGeometry(mesh.TriangleMesh), config_.Bodies + index);
+            collection_->add(*actor);
+            index++;
+        }
+    }
+
+    void BuildJoints()
+    {
+        if (bodies_.size() < 2) return;
+
+        auto scale = physics_.getTolerancesScale();
+        for (uint32_t i = 0; i < config_.Joints; i++) {
+            auto actor0 = bodies_[i % bodies_.size()];
+            auto actor1 = bodies_[(i + 1) % bodies_.size()];
+            auto joint = PxD6JointCreate(physics_, actor0, PxTransform(PxVec3(1.0f, 0.0f, 0.0f)),
+                actor1, PxTransform(PxVec3(-1.0f, 0.0f, 0.0f)));
+            joint->setName(MakeName("Joint_", i));
+
+            // Exercise every limit and drive type
+            joint->setMotion(PxD6Axis::eX, PxD6Motion::eLIMITED);
+            joint->setMotion(PxD6Axis::eY, PxD6Motion::eLIMITED);
+            joint->setMotion(PxD6Axis::eZ, PxD6Motion::eLOCKED);
+            joint->setMotion(PxD6Axis::eTWIST, PxD6Motion::eLIMITED);
+            joint->setMotion(PxD6Axis::eSWING1, PxD6Motion::eLIMITED);
+            joint->setMotion(PxD6Axis::eSWING2, PxD6Motion::eLIMITED);
+
+            joint->setDistanceLimit(PxJointLinearLimit(scale, 2.0f));
+            joint->setLinearLimit(PxD6Axis::eX, PxJointLinearLimitPair(scale, -0.5f, 0.5f));
+            joint->setLinearLimit(PxD6Axis::eY, PxJointLinearLimitPair(scale, -0.25f, 0.25f));
+            joint->setTwistLimit(PxJointAngularLimitPair(-0.5f, 0.5f));
+            if (i % 2 == 0) {
+                joint->setSwingLimit(PxJointLimitCone(0.4f, 0.3f));
+            } else {
+                joint->setPyramidSwingLimit(PxJointLimitPyramid(-0.3f, 0.3f, -0.2f, 0.2f));
+            }
+
+            joint->setDrive(PxD6Drive::eX, PxD6JointDrive(10.0f, 1.0f, PX_MAX_F32, true));
+            joint->setDrive(PxD6Drive::eSLERP, PxD6JointDrive(5.0f, 0.5f, 100.0f, false));
+
+            collection_->add(*joint->getConstraint());
+            collection_->add(*joint);
+        }
+    }
+
+    void BuildArticulations()
+    {
+        uint32_t linkIndex = 0;
+        for (uint32_t a = 0; a < config_.Articulations; a++) {
+            auto articulation = physics_.createArticulation();
+            collection_->add(*articulation);
+
+            PxArticulationLink* parent = nullptr;
+            for (uint32_t depth = 0; depth < config_.ArticulationDepth; depth++) {
+                auto link = articulation->createLink(parent, PxTransform(PxVec3((float)a * 5.0f, 50.0f - depth * 1.5f, 0.0f)));
+                link->setName(MakeName("Link_", linkIndex));
+                AddBodyShape(*link, linkIndex);
+                PxRigidBodyExt::updateMassAndInertia(*link, 1.0f);
+
+                if (auto joint = static_cast<PxArticulationJoint*>(link->getInboundJoint())) {
+                    joint->setParentPose(PxTransform(PxVec3(0.0f, -0.75f, 0.0f)));
+                    joint->setChildPose(PxTransform(PxVec3(0.0f, 0.75f, 0.0f)));
+                    joint->setSwingLimitEnabled(true);
+                    joint->setSwingLimit(0.4f, 0.4f);
+                    joint->setTwistLimitEnabled(true);
+                    joint->setTwistLimit(-0.3f, 0.3f);
+                    collection_->add(*joint);
+                }
+
+                collection_->add(*link);
+                parent = link;
+                linkIndex++;
+            }
+        }
+    }
+};
+
+
+// Writes the collection against a shared material collection the way PhysicsTool --shared-materials
+// does, then loads it back with the shared collection as external references
+void VerifySharedMaterialRoundTrip(PhysXConverter& converter, std::vector<uint8_t> const& bin)
+{
+    auto dependent = converter.LoadCollectionFromBinary(bin);
+    if (!dependent) throw std::runtime_error("Round trip: failed to load binary collection");
+    auto expected = converter.SaveCollectionToXml(*dependent);
+
+    auto shared = converter.CreateSharedMaterials();
+    shared->Share(*dependent);
+    auto dependentBin = converter.SaveCollectionToBinary(*dependent, &shared->Collection());
+    auto sharedBin = converter.SaveCollectionToBinary(shared->Collection());
+    converter.ReleaseCollection(dependent);
+    shared.reset();
+    if (dependentBin.empty() || sharedBin.empty()) throw std::runtime_error("Round trip: failed to serialize against shared materials");
+
+    auto refs = converter.LoadCollectionFromBinary(sharedBin);
+    if (!refs) throw std::runtime_error("Round trip: failed to load shared material collection");
+    auto loaded = converter.LoadCollectionFromBinary(dependentBin, refs);
+    if (!loaded) throw std::runtime_error("Round trip: failed to load collection against shared materials");
+
+    auto xml = converter.SaveCollectionToXml(*loaded);
+    auto rebin = converter.SaveCollectionToBinary(*loaded, refs);
+    converter.ReleaseCollection(loaded);
+    converter.ReleaseCollection(refs);
+    if (rebin != dependentBin) throw std::runtime_error("Round trip: binary output changed after reloading against shared materials");
+
+    // The XML output must be loadable without the shared collection
+    auto standalone = converter.LoadCollectionFromXml(xml);
+    auto xml2 = converter.SaveCollectionToXml(*standalone);
+    converter.ReleaseCollection(standalone);
+    if (xml != xml2 || xml.size() != expected.size()) throw std::runtime_error("Round trip: XML output differs from the original collection");
+}
+
+
+void RunPhase(PhaseResult& phase, uint32_t iterations, std::function<void()> const& fn)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        phase.Times.push_back(TimeMs(fn));
+    }
+}
+
+
+std::string ToJson(BenchConfig const& config, std::vector<PhaseResult> const& phases, uint64_t xmlSize, uint64_t binarySize, uint32_t objects)
+{
+    std::ostringstream json;
+    json.precision(6);
+    json << std::fixed;
+
+    json << "{\n";
+    json << "  \"config\": {\n"
+        << "    \"bodies\": " << config.Bodies << ",\n"
+        << "    \"joints\": " << config.Joints << ",\n"
+        << "    \"articulations\": " << config.Articulations << ",\n"
+        << "    \"articulationDepth\": " << config.ArticulationDepth << ",\n"
+        << "    \"meshes\": " << config.Meshes << ",\n"
+        << "    \"meshVertices\": " << config.MeshVertices << ",\n"
+        << "    \"iterations\": " << config.Iterations << "\n"
+        << "  },\n";
+    json << "  \"objects\": " << objects << ",\n";
+    json << "  \"xmlBytes\": " << xmlSize << ",\n";
+    json << "  \"binaryBytes\": " << binarySize << ",\n";
+    json << "  \"phases\": [\n";
+
+    for (std::size_t i = 0; i < phases.size(); i++) {
+        auto const& phase = phases[i];
+        auto times = phase.Times;
+        std::sort(times.begin(), times.end());
+        double total = 0.0;
+        for (auto t : times) total += t;
+
+        auto median = times[times.size() / 2];
+        auto seconds = median / 1000.0;
+
+        json << "    {\n"
+            << "      \"name\": \"" << phase.Name << "\",\n"
+            << "      \"minMs\": " << times.front() << ",\n"
+            << "      \"medianMs\": " << median << ",\n"
+            << "      \"meanMs\": " << (total / times.size()) << ",\n"
+            << "      \"maxMs\": " << times.back() << ",\n"
+            << "      \"bytes\": " << phase.Bytes << ",\n"
+            << "      \"mbPerSec\": " << (seconds > 0.0 ? phase.Bytes / seconds / (1024.0 * 1024.0) : 0.0) << ",\n"
+            << "      \"objectsPerSec\": " << (seconds > 0.0 ? phase.Objects / seconds : 0.0) << "\n"
+            << "    }" << (i + 1 < phases.size() ? "," : "") << "\n";
+    }
+
+    json << "  ],\n";
+    json << "  \"peakRssBytes\": " << GetPeakRss() << "\n";
+    json << "}\n";
+    return json.str();
+}
+
+
+void PrintUsage()
+{
+    std::cout << "Usage: PhysicsBench [options]" << std::endl
+        << "Options:" << std::endl
+        << "    --bodies <n>                Number of rigid bodies (default: 1000)" << std::endl
+        << "    --joints <n>                Number of D6 joints (default: 1000)" << std::endl
+        << "    --articulations <n>         Number of articulations (default: 8)" << std::endl
+        << "    --articulation-depth <n>    Links per articulation chain (default: 32)" << std::endl
+        << "    --meshes <n>                Number of convex and triangle meshes (default: 16)" << std::endl
+        << "    --mesh-vertices <n>         Vertices per mesh (default: 4096)" << std::endl
+        << "    --iterations <n>            Repetitions of each phase (default: 5)" << std::endl
+        << "    --output <file>             Write JSON results to a file instead of stdout" << std::endl;
+}
+
+
+int main(int argc, char** argv)
+{
+    BenchConfig config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            PrintUsage();
+            return 1;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--output") {
+            config.OutputPath = value;
+            continue;
+        }
+
+        auto number = (uint32_t)std::stoul(value);
+        if (arg == "--bodies") {
+            config.Bodies = number;
+        } else if (arg == "--joints") {
+            config.Joints = number;
+        } else if (arg == "--articulations") {
+            config.Articulations = number;
+        } else if (arg == "--articulation-depth") {
+            config.ArticulationDepth = number;
+        } else if (arg == "--meshes") {
+            config.Meshes = number;
+        } else if (arg == "--mesh-vertices") {
+            config.MeshVertices = number;
+        } else if (arg == "--iterations") {
+            config.Iterations = std::max(1u, number);
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    try {
+        PhysXConverter converter;
+        if (!converter.InitPhysX()) {
+            std::cerr << "Failed to initialize PhysX runtime" << std::endl;
+            return 1;
+        }
+
+        CollectionBuilder builder(converter, config);
+        auto collection = builder.Build();
+        auto objects = collection->getNbObjects();
+
+        auto xml = converter.SaveCollectionToXml(*collection);
+        auto bin = converter.SaveCollectionToBinary(*collection);
+        if (bin.empty()) throw std::runtime_error("Failed to serialize synthetic collection");
+
+        VerifySharedMaterialRoundTrip(converter, bin);
+
+        std::vector<PhaseResult> phases;
+
+        {
+            std::mt19937 rng(1234);
+            auto templateJobs = MakeMeshJobs(config, rng);
+            PhaseResult phase{ "Cook" };
+            phase.Bytes = MeshInputBytes(templateJobs);
+            phase.Objects = templateJobs.size();
+            for (uint32_t i = 0; i < config.Iterations; i++) {
+                auto jobs = templateJobs;
+                phase.Times.push_back(TimeMs([&]() { converter.CookMeshes(jobs); }));
+                ReleaseMeshes(jobs);
+            }
+            phases.push_back(std::move(phase));
+        }
+
+        {
+            PhaseResult phase{ "SaveCollectionToXml", {}, xml.size(), objects };
+            RunPhase(phase, config.Iterations, [&]() { converter.SaveCollectionToXml(*collection); });
+            phases.push_back(std::move(phase));
+        }
+
+        {
+            PhaseResult phase{ "SaveCollectionToBinary", {}, bin.size(), objects };
+            RunPhase(phase, config.Iterations, [&]() { converter.SaveCollectionToBinary(*collection); });
+            phases.push_back(std::move(phase));
+        }
+
+        {
+            // Includes cooking of the meshes referenced by the document
+            PhaseResult phase{ "LoadCollectionFromXml", {}, xml.size(), objects };
+            RunPhase(phase, config.Iterations, [&]() {
+                converter.ReleaseCollection(converter.LoadCollectionFromXml(xml));
+            });
+            phases.push_back(std::move(phase));
+        }
+
+        {
+            PhaseResult phase{ "LoadCollectionFromBinary", {}, bin.size(), objects };
+            RunPhase(phase, config.Iterations, [&]() {
+                auto loaded = converter.LoadCollectionFromBinary(bin);
+                if (!loaded) throw std::runtime_error("Failed to load binary collection");
+                converter.ReleaseCollection(loaded);
+            });
+            phases.push_back(std::move(phase));
+        }
+
+        auto json = ToJson(config, phases, xml.size(), bin.size(), objects);
+        if (config.OutputPath.empty()) {
+            std::cout << json;
+        } else {
+            std::ofstream f(config.OutputPath.c_str(), std::ios::out | std::ios::trunc);
+            if (!f.good()) throw std::runtime_error("Failed to open output file: " + config.OutputPath);
+            f << json;
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
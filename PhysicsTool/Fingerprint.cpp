@@ -0,0 +1,180 @@
+#include "Fingerprint.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+static constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+static constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr uint64_t Prime3 = 0x165667B19E3779F9ull;
+static constexpr uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+static constexpr uint64_t Prime5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t Rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t Read64(uint8_t const* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t Read32(uint8_t const* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t Round(uint64_t acc, uint64_t input)
+{
+    acc += input * Prime2;
+    acc = Rotl(acc, 31);
+    return acc * Prime1;
+}
+
+static inline uint64_t MergeRound(uint64_t acc, uint64_t val)
+{
+    acc ^= Round(0, val);
+    return acc * Prime1 + Prime4;
+}
+
+
+XxHash64::XxHash64(uint64_t seed)
+    : v1_(seed + Prime1 + Prime2),
+    v2_(seed + Prime2),
+    v3_(seed),
+    v4_(seed - Prime1),
+    seed_(seed)
+{}
+
+
+void XxHash64::Update(void const* data, std::size_t size)
+{
+    auto p = reinterpret_cast<uint8_t const*>(data);
+    auto end = p + size;
+    totalSize_ += size;
+
+    if (bufSize_ + size < sizeof(buf_)) {
+        memcpy(buf_ + bufSize_, p, size);
+        bufSize_ += size;
+        return;
+    }
+
+    if (bufSize_ > 0) {
+        auto fill = sizeof(buf_) - bufSize_;
+        memcpy(buf_ + bufSize_, p, fill);
+        p += fill;
+        v1_ = Round(v1_, Read64(buf_));
+        v2_ = Round(v2_, Read64(buf_ + 8));
+        v3_ = Round(v3_, Read64(buf_ + 16));
+        v4_ = Round(v4_, Read64(buf_ + 24));
+        bufSize_ = 0;
+    }
+
+    while (end - p >= 32) {
+        v1_ = Round(v1_, Read64(p));
+        v2_ = Round(v2_, Read64(p + 8));
+        v3_ = Round(v3_, Read64(p + 16));
+        v4_ = Round(v4_, Read64(p + 24));
+        p += 32;
+    }
+
+    bufSize_ = end - p;
+    memcpy(buf_, p, bufSize_);
+}
+
+
+uint64_t XxHash64::Digest() const
+{
+    uint64_t h;
+    if (totalSize_ >= 32) {
+        h = Rotl(v1_, 1) + Rotl(v2_, 7) + Rotl(v3_, 12) + Rotl(v4_, 18);
+        h = MergeRound(h, v1_);
+        h = MergeRound(h, v2_);
+        h = MergeRound(h, v3_);
+        h = MergeRound(h, v4_);
+    } else {
+        h = seed_ + Prime5;
+    }
+
+    h += totalSize_;
+
+    auto p = buf_;
+    auto end = buf_ + bufSize_;
+    while (end - p >= 8) {
+        h ^= Round(0, Read64(p));
+        h = Rotl(h, 27) * Prime1 + Prime4;
+        p += 8;
+    }
+
+    if (end - p >= 4) {
+        h ^= (uint64_t)Read32(p) * Prime1;
+        h = Rotl(h, 23) * Prime2 + Prime3;
+        p += 4;
+    }
+
+    while (p < end) {
+        h ^= (*p) * Prime5;
+        h = Rotl(h, 11) * Prime1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= Prime2;
+    h ^= h >> 29;
+    h *= Prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+
+void FingerprintManifest::Load(std::string const& path)
+{
+    outputs_.clear();
+    if (!std::filesystem::exists(path)) return;
+
+    std::ifstream f(path.c_str(), std::ios::in);
+    if (!f.good()) throw std::runtime_error(std::string("Failed to open manifest: ") + path);
+
+    // Each line contains a fingerprint in hex and the output path it was written to
+    std::string line;
+    while (std::getline(f, line)) {
+        auto sep = line.find(' ');
+        if (sep == std::string::npos) continue;
+
+        auto fingerprint = std::stoull(line.substr(0, sep), nullptr, 16);
+        outputs_[line.substr(sep + 1)] = fingerprint;
+    }
+}
+
+
+void FingerprintManifest::Save(std::string const& path) const
+{
+    std::ofstream f(path.c_str(), std::ios::out | std::ios::trunc);
+    if (!f.good()) throw std::runtime_error(std::string("Failed to open manifest for writing: ") + path);
+
+    for (auto const& output : outputs_) {
+        char hex[24];
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)output.second);
+        f << hex << ' ' << output.first << '\n';
+    }
+}
+
+
+bool FingerprintManifest::Matches(std::string const& outputPath, uint64_t fingerprint) const
+{
+    auto it = outputs_.find(outputPath);
+    return it != outputs_.end() && it->second == fingerprint && std::filesystem::exists(outputPath);
+}
+
+
+void FingerprintManifest::Update(std::string const& outputPath, uint64_t fingerprint)
+{
+    outputs_[outputPath] = fingerprint;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <string>
+
+// Streaming XXH64 hash
+class XxHash64
+{
+public:
+    XxHash64(uint64_t seed = 0);
+
+    void Update(void const* data, std::size_t size);
+    uint64_t Digest() const;
+
+private:
+    uint64_t v1_, v2_, v3_, v4_;
+    uint64_t seed_;
+    uint64_t totalSize_{ 0 };
+    uint8_t buf_[32];
+    std::size_t bufSize_{ 0 };
+};
+
+
+// Fingerprints of the collections that were used to write each output file
+class FingerprintManifest
+{
+public:
+    void Load(std::string const& path);
+    void Save(std::string const& path) const;
+
+    bool Matches(std::string const& outputPath, uint64_t fingerprint) const;
+    void Update(std::string const& outputPath, uint64_t fingerprint);
+
+private:
+    std::map<std::string, uint64_t> outputs_;
+};
@@ -0,0 +1,254 @@
+#include "PhysicsTool.h"
+#include <memory>
+
+
+std::vector<uint8_t> LoadFile(std::string const& path)
+{
+    std::vector<uint8_t> bin;
+    std::ifstream f(path.c_str(), std::ios::binary | std::ios::in);
+    if (!f.good()) throw std::runtime_error(std::string("Failed to open file: ") + path);
+
+    f.seekg(0, std::ios::end);
+    auto size = (std::streamoff)f.tellg();
+    f.seekg(0, std::ios::beg);
+    bin.resize(size);
+
+    f.read(reinterpret_cast<char*>(bin.data()), bin.size());
+    return bin;
+}
+
+
+void WriteFile(std::string const& path, std::vector<uint8_t> const& contents)
+{
+    std::ofstream f(path.c_str(), std::ios::binary | std::ios::out);
+    if (!f.good()) throw std::runtime_error(std::string("Failed to open file for writing: ") + path);
+
+    f.write(reinterpret_cast<char const*>(contents.data()), contents.size());
+}
+
+
+void PrintUsage()
+{
+    std::cout << "Usage: PhysicsTool [options] <input file> <output file> [<input file> <output file> ...]" << std::endl
+        << "Options:" << std::endl
+        << "    --mesh-cache <dir>          Reuse cooked meshes stored in this directory" << std::endl
+        << "    --mesh-cache-size <MB>      Size limit of the mesh cache (default: 1024)" << std::endl
+        << "    --shared-materials <file>   Move deduplicated materials of all outputs to a shared" << std::endl
+        << "                                collection that the .bin outputs reference" << std::endl
+        << "    --external-refs <file>      Load .bin inputs written with --shared-materials against" << std::endl
+        << "                                this shared collection; .bin outputs keep referencing it" << std::endl
+        << "    --manifest <file>           Skip outputs whose input file, options and tool version" << std::endl
+        << "                                match the manifest" << std::endl
+        << "    --fingerprint               Print the structural fingerprint of each input file instead" << std::endl
+        << "                                of converting; it doesn't depend on the input format" << std::endl;
+}
+
+
+std::string GetExtension(std::string const& path)
+{
+    std::string ext = path.length() > 4 ? path.substr(path.size() - 4) : "";
+    if (ext != ".bin" && ext != ".xml") throw std::runtime_error(std::string("File must be a .bin or .xml file: ") + path);
+    return ext;
+}
+
+
+struct ConversionStats
+{
+    uint64_t StandaloneSize{ 0 };
+    uint64_t SharedSize{ 0 };
+    uint32_t Skipped{ 0 };
+};
+
+
+PxCollection* LoadInput(PhysXConverter& converter, std::string const& inputPath, std::vector<uint8_t> const& input,
+    PxCollection* externalRefs)
+{
+    bool inputIsXml = (GetExtension(inputPath) == ".xml");
+    auto collection = inputIsXml ? converter.LoadCollectionFromXml(input) : converter.LoadCollectionFromBinary(input, externalRefs);
+    if (!collection) throw std::runtime_error("Unable to load resource collection from source file: " + inputPath);
+    return collection;
+}
+
+
+void PrintFingerprint(PhysXConverter& converter, std::string const& inputPath, PxCollection* externalRefs)
+{
+    auto collection = LoadInput(converter, inputPath, LoadFile(inputPath), externalRefs);
+    char hex[24];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)converter.FingerprintCollection(*collection));
+    converter.ReleaseCollection(collection);
+
+    std::cout << hex << " " << inputPath << std::endl;
+}
+
+
+// Fingerprint of everything that determines the contents of an output file: the input bytes,
+// the input and output formats, the external references and the version of the converter
+uint64_t InputFingerprint(std::vector<uint8_t> const& input, std::string const& inputPath, std::string const& outputPath,
+    uint64_t optionsHash)
+{
+    XxHash64 hash(optionsHash);
+    auto inputExt = GetExtension(inputPath);
+    auto outputExt = GetExtension(outputPath);
+    hash.Update(inputExt.data(), inputExt.size());
+    hash.Update(outputExt.data(), outputExt.size());
+    hash.Update(input.data(), input.size());
+    return hash.Digest();
+}
+
+
+void ConvertFile(PhysXConverter& converter, std::string const& inputPath, std::string const& outputPath,
+    SharedMaterials* sharedMaterials, PxCollection* externalRefs, FingerprintManifest* manifest, uint64_t optionsHash,
+    ConversionStats& stats)
+{
+    bool outputIsXml = (GetExtension(outputPath) == ".xml");
+    auto input = LoadFile(inputPath);
+
+    // Check the manifest before parsing, so unchanged inputs cost only a read and a hash
+    uint64_t fingerprint = 0;
+    if (manifest) {
+        fingerprint = InputFingerprint(input, inputPath, outputPath, optionsHash);
+        if (manifest->Matches(outputPath, fingerprint)) {
+            stats.Skipped++;
+            return;
+        }
+    }
+
+    auto collection = LoadInput(converter, inputPath, input, externalRefs);
+
+    std::vector<uint8_t> output;
+    if (sharedMaterials) {
+        if (outputIsXml) throw std::runtime_error("Shared materials can only be used with .bin outputs");
+
+        stats.StandaloneSize += converter.SaveCollectionToBinary(*collection).size();
+        sharedMaterials->Share(*collection);
+        output = converter.SaveCollectionToBinary(*collection, &sharedMaterials->Collection());
+        stats.SharedSize += output.size();
+    } else {
+        output = outputIsXml ? converter.SaveCollectionToXml(*collection) : converter.SaveCollectionToBinary(*collection, externalRefs);
+    }
+
+    converter.ReleaseCollection(collection);
+
+    if (output.empty()) throw std::runtime_error("Failed to serialize collection: " + inputPath);
+    WriteFile(outputPath, output);
+
+    if (manifest) {
+        manifest->Update(outputPath, fingerprint);
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> paths;
+    std::string meshCachePath;
+    std::string meshCacheSize = "1024";
+    std::string sharedMaterialsPath;
+    std::string externalRefsPath;
+    std::string manifestPath;
+    bool fingerprintOnly = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--mesh-cache" && i + 1 < argc) {
+            meshCachePath = argv[++i];
+        } else if (arg == "--mesh-cache-size" && i + 1 < argc) {
+            meshCacheSize = argv[++i];
+        } else if (arg == "--shared-materials" && i + 1 < argc) {
+            sharedMaterialsPath = argv[++i];
+        } else if (arg == "--external-refs" && i + 1 < argc) {
+            externalRefsPath = argv[++i];
+        } else if (arg == "--manifest" && i + 1 < argc) {
+            manifestPath = argv[++i];
+        } else if (arg == "--fingerprint") {
+            fingerprintOnly = true;
+        } else if (arg.starts_with("--")) {
+            PrintUsage();
+            return 1;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+
+    if (paths.empty() || (!fingerprintOnly && (paths.size() % 2) != 0)) {
+        PrintUsage();
+        return 1;
+    }
+
+    try {
+        PhysXConverter converter;
+        if (!converter.InitPhysX()) {
+            std::cout << "Failed to initialize PhysX runtime" << std::endl;
+            return 1;
+        }
+
+        std::unique_ptr<MeshCache> meshCache;
+        if (!meshCachePath.empty()) {
+            meshCache = std::make_unique<MeshCache>(meshCachePath, std::stoull(meshCacheSize) * 1024 * 1024);
+            converter.SetMeshCache(meshCache.get());
+        }
+
+        // Options that change the output for the same input; part of every manifest fingerprint
+        XxHash64 options(PhysXConverter::OutputVersion);
+        PxCollection* externalRefs{ nullptr };
+        if (!externalRefsPath.empty()) {
+            if (GetExtension(externalRefsPath) != ".bin") throw std::runtime_error("External reference collection must be a .bin file");
+            auto refs = LoadFile(externalRefsPath);
+            options.Update(refs.data(), refs.size());
+            externalRefs = converter.LoadCollectionFromBinary(refs);
+            if (!externalRefs) throw std::runtime_error("Unable to load external reference collection: " + externalRefsPath);
+        }
+
+        if (fingerprintOnly) {
+            for (auto const& path : paths) {
+                PrintFingerprint(converter, path, externalRefs);
+            }
+
+            return 0;
+        }
+
+        std::unique_ptr<SharedMaterials> sharedMaterials;
+        if (!sharedMaterialsPath.empty()) {
+            if (GetExtension(sharedMaterialsPath) != ".bin") throw std::runtime_error("Shared material collection must be a .bin file");
+            if (externalRefs) throw std::runtime_error("--external-refs cannot be used together with --shared-materials");
+            // The shared collection only contains materials of converted inputs, so outputs can't be skipped individually
+            if (!manifestPath.empty()) throw std::runtime_error("--manifest cannot be used together with --shared-materials");
+            sharedMaterials = converter.CreateSharedMaterials();
+        }
+
+        std::unique_ptr<FingerprintManifest> manifest;
+        if (!manifestPath.empty()) {
+            manifest = std::make_unique<FingerprintManifest>();
+            manifest->Load(manifestPath);
+        }
+
+        ConversionStats stats;
+        for (std::size_t i = 0; i < paths.size(); i += 2) {
+            ConvertFile(converter, paths[i], paths[i + 1], sharedMaterials.get(), externalRefs, manifest.get(), options.Digest(), stats);
+        }
+
+        if (manifest) {
+            manifest->Save(manifestPath);
+            std::cout << "Skipped " << stats.Skipped << " of " << (paths.size() / 2) << " unchanged outputs" << std::endl;
+        }
+
+        if (sharedMaterials) {
+            auto base = converter.SaveCollectionToBinary(sharedMaterials->Collection());
+            WriteFile(sharedMaterialsPath, base);
+            stats.SharedSize += base.size();
+
+            std::cout << "Shared materials: " << sharedMaterials->NumShared() << " unique of " << sharedMaterials->NumReplaced()
+                << "; saved " << ((int64_t)stats.StandaloneSize - (int64_t)stats.SharedSize) << " bytes ("
+                << stats.StandaloneSize << " standalone, " << stats.SharedSize << " shared)" << std::endl;
+        }
+
+        if (meshCache) {
+            std::cout << "Mesh cache: " << meshCache->Hits() << " hits, " << meshCache->Misses() << " misses" << std::endl;
+        }
+    } catch (std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
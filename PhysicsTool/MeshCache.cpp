@@ -0,0 +1,178 @@
+#include "MeshCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#if defined(_WIN32)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+struct MeshCacheHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint64_t KeySize;
+    uint64_t CookedSize;
+};
+
+
+MeshCache::MeshCache(fs::path const& path, uint64_t maxSize)
+    : path_(path), maxSize_(maxSize)
+{
+    fs::create_directories(path_);
+}
+
+
+fs::path MeshCache::EntryPath(std::string const& key) const
+{
+    // FNV-1a; only used for addressing, the key itself is verified on lookup
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (auto c : key) {
+        hash = (hash ^ (uint8_t)c) * 0x100000001b3ull;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.mesh", (unsigned long long)hash);
+    return path_ / name;
+}
+
+
+bool MeshCache::Get(std::string const& key, std::vector<uint8_t>& cooked)
+{
+    auto path = EntryPath(key);
+    std::error_code ec;
+    auto fileSize = fs::file_size(path, ec);
+    std::ifstream f(path, std::ios::binary | std::ios::in);
+    if (!ec && f.good()) {
+        MeshCacheHeader header;
+        f.read(reinterpret_cast<char*>(&header), sizeof(header));
+        // A truncated or corrupt header must not drive the size of the allocation below
+        if (f.good() && header.Magic == Magic && header.Version == Version && header.KeySize == key.size()
+            && fileSize >= sizeof(header) + key.size()
+            && header.CookedSize == fileSize - sizeof(header) - key.size()) {
+            std::string entryKey(key.size(), '\0');
+            f.read(entryKey.data(), entryKey.size());
+            if (f.good() && entryKey == key) {
+                cooked.resize(header.CookedSize);
+                f.read(reinterpret_cast<char*>(cooked.data()), cooked.size());
+                if (f.good()) {
+                    f.close();
+                    // Refresh the modification time, it is used as the LRU timestamp
+                    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+                    hits_++;
+                    return true;
+                }
+
+                cooked.clear();
+            }
+        }
+    }
+
+    misses_++;
+    return false;
+}
+
+
+void MeshCache::Put(std::string const& key, std::vector<uint8_t> const& cooked)
+{
+    auto path = EntryPath(key);
+
+    // Write to a temporary file first so concurrent readers never see partial entries.
+    // The name is unique across threads and processes sharing the cache directory.
+    auto tempPath = path;
+    tempPath += "." + std::to_string(getpid()) + "." + std::to_string(tempSequence_++) + ".tmp";
+
+    {
+        std::ofstream f(tempPath, std::ios::binary | std::ios::out | std::ios::trunc);
+        if (!f.good()) return;
+
+        MeshCacheHeader header{ Magic, Version, key.size(), cooked.size() };
+        f.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        f.write(key.data(), key.size());
+        f.write(reinterpret_cast<char const*>(cooked.data()), cooked.size());
+        if (!f.good()) {
+            f.close();
+            std::error_code ec;
+            fs::remove(tempPath, ec);
+            return;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tempPath, path, ec);
+    if (ec) {
+        fs::remove(tempPath, ec);
+        return;
+    }
+
+    auto size = estimatedSize_.load();
+    while (size != UINT64_MAX
+        && !estimatedSize_.compare_exchange_weak(size, size + sizeof(MeshCacheHeader) + key.size() + cooked.size())) {}
+}
+
+
+void MeshCache::Remove(std::string const& key)
+{
+    std::error_code ec;
+    fs::remove(EntryPath(key), ec);
+}
+
+
+void MeshCache::TrimIfNeeded()
+{
+    // The first call always scans, as the size of entries left by previous runs is unknown
+    if (estimatedSize_ <= maxSize_) return;
+
+    Trim();
+}
+
+
+void MeshCache::Trim()
+{
+    std::lock_guard<std::mutex> lock(trimMutex_);
+
+    struct Entry
+    {
+        fs::path Path;
+        fs::file_time_type LastUsed;
+        uint64_t Size;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t totalSize = 0;
+    std::error_code ec;
+    for (auto const& file : fs::directory_iterator(path_, ec)) {
+        if (file.path().extension() != ".mesh") continue;
+
+        Entry entry{ file.path(), file.last_write_time(ec), file.file_size(ec) };
+        if (ec) continue;
+        totalSize += entry.Size;
+        entries.push_back(std::move(entry));
+    }
+
+    if (totalSize <= maxSize_) {
+        estimatedSize_ = totalSize;
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b) {
+        return a.LastUsed < b.LastUsed;
+    });
+
+    // Trim below the limit so the next few entries written don't immediately trigger another scan
+    auto targetSize = maxSize_ - maxSize_ / 8;
+    for (auto const& entry : entries) {
+        if (totalSize <= targetSize) break;
+        if (fs::remove(entry.Path, ec)) {
+            totalSize -= entry.Size;
+        }
+    }
+
+    estimatedSize_ = totalSize;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// On-disk cache of cooked mesh streams, addressed by a hash of the cooking inputs.
+// Entries store the full key, so hash collisions are detected and treated as misses.
+// Recently used entries are kept when the cache is trimmed to its size limit.
+class MeshCache
+{
+public:
+    MeshCache(std::filesystem::path const& path, uint64_t maxSize);
+
+    bool Get(std::string const& key, std::vector<uint8_t>& cooked);
+    void Put(std::string const& key, std::vector<uint8_t> const& cooked);
+    // Removes an entry whose cooked data turned out to be unusable
+    void Remove(std::string const& key);
+    // Scans the cache directory only when the entries written since the last scan may exceed the size limit
+    void TrimIfNeeded();
+    void Trim();
+
+    inline uint64_t Hits() const
+    {
+        return hits_;
+    }
+
+    inline uint64_t Misses() const
+    {
+        return misses_;
+    }
+
+private:
+    static constexpr uint32_t Magic = 0x434d5850; // "PXMC"
+    static constexpr uint32_t Version = 1;
+
+    std::filesystem::path path_;
+    uint64_t maxSize_;
+    std::atomic<uint64_t> hits_{ 0 };
+    std::atomic<uint64_t> misses_{ 0 };
+    std::atomic<uint64_t> tempSequence_{ 0 };
+    // Cache size at the last scan plus the size of the entries written since; unknown until the first scan
+    std::atomic<uint64_t> estimatedSize_{ UINT64_MAX };
+    std::mutex trimMutex_;
+
+    std::filesystem::path EntryPath(std::string const& key) const;
+};
@@ -7,14 +7,23 @@ class PhysXExporterAllocator : public PxAllocatorCallback
 public:
     void* allocate(size_t size, const char*, const char*, int)
     {
+#if defined(_WIN32)
         void* ptr = _aligned_malloc(size, 16);
+#else
+        // aligned_alloc() requires the size to be a multiple of the alignment
+        void* ptr = aligned_alloc(16, (size + 15) & ~(size_t)15);
+#endif
         memset(ptr, 0, size);
         return ptr;
     }
 
     void deallocate(void* ptr)
     {
+#if defined(_WIN32)
         _aligned_free(ptr);
+#else
+        free(ptr);
+#endif
     }
 };
 
@@ -32,7 +41,10 @@ bool PhysXConverter::InitPhysX()
         PxTolerancesScale(), false, nullptr);
     if (!physics_) return false;
 
-    cooking_ = PxCreateCooking(PX_PHYSICS_VERSION, *foundation_, PxCookingParams(PxTolerancesScale()));
+    // Game collections use the BVH33 midphase, cook new meshes the same way
+    PxCookingParams cookingParams{ PxTolerancesScale() };
+    cookingParams.midphaseDesc = PxMeshMidPhase::eBVH33;
+    cooking_ = PxCreateCooking(PX_PHYSICS_VERSION, *foundation_, cookingParams);
     if (!cooking_) return false;
 
     if (!PxInitExtensions(*physics_, nullptr)) return false;
@@ -61,15 +73,28 @@ void PhysXConverter::ShutdownPhysX()
 }
 
 
-PxCollection* PhysXConverter::LoadCollectionFromBinary(std::span<uint8_t> const& bin)
+PxCollection* PhysXConverter::LoadCollectionFromBinary(std::span<uint8_t const> bin, PxCollection* externalRefs)
 {
     auto binSize = bin.size();
-    auto binInput = new uint8_t[binSize + PX_SERIAL_FILE_ALIGN];
-    // TODO - release memory block after use
-    void* memory128 = (void*)((uintptr_t(binInput) + PX_SERIAL_FILE_ALIGN) & ~(PX_SERIAL_FILE_ALIGN - 1));
+    std::unique_ptr<uint8_t[]> binInput(new uint8_t[binSize + PX_SERIAL_FILE_ALIGN]);
+    void* memory128 = (void*)((uintptr_t(binInput.get()) + PX_SERIAL_FILE_ALIGN) & ~(PX_SERIAL_FILE_ALIGN - 1));
     memcpy(memory128, bin.data(), binSize);
 
-    return PxSerialization::createCollectionFromBinary(memory128, *registry_);
+    auto collection = PxSerialization::createCollectionFromBinary(memory128, *registry_, externalRefs);
+    if (collection) {
+        // Deserialized objects live in the memory block, so it is kept until the collection is released
+        binaryBlocks_.insert(std::make_pair(collection, std::move(binInput)));
+    }
+
+    return collection;
+}
+
+
+void PhysXConverter::ReleaseCollection(PxCollection* collection)
+{
+    PxCollectionExt::releaseObjects(*collection);
+    collection->release();
+    binaryBlocks_.erase(collection);
 }
 
 
@@ -93,77 +118,15 @@ private:
 };
 
 
-std::vector<uint8_t> PhysXConverter::SaveCollectionToBinary(PxCollection& collection)
-{
-    KazMemoryOutputStream outStream;
-    if (!PxSerialization::serializeCollectionToBinaryDeterministic(outStream, collection, *registry_, nullptr, true)) return {};
-
-    return outStream.contents();
-}
-
-
-std::vector<uint8_t> LoadFile(std::string const& path)
-{
-    std::vector<uint8_t> bin;
-    std::ifstream f(path.c_str(), std::ios::binary | std::ios::in);
-    if (!f.good()) throw std::runtime_error(std::string("Failed to open file: ") + path);
-
-    f.seekg(0, std::ios::end);
-    auto size = (std::streamoff)f.tellg();
-    f.seekg(0, std::ios::beg);
-    bin.resize(size);
-
-    f.read(reinterpret_cast<char*>(bin.data()), bin.size());
-    return bin;
-}
-
-
-void WriteFile(std::string const& path, std::vector<uint8_t> const& contents)
+std::vector<uint8_t> PhysXConverter::SaveCollectionToBinary(PxCollection& collection, PxCollection* externalRefs)
 {
-    std::ofstream f(path.c_str(), std::ios::binary | std::ios::out);
-    if (!f.good()) throw std::runtime_error(std::string("Failed to open file for writing: ") + path);
-
-    f.write(reinterpret_cast<char const*>(contents.data()), contents.size());
-}
-
-
-int main(int argc, char** argv)
-{
-    if (argc != 3) {
-        std::cout << "Usage: PhysicsTool <input file> <output file>" << std::endl;
-        return 1;
+    if (externalRefs) {
+        // Pull in any dependencies that aren't provided by the referenced collection
+        PxSerialization::complete(collection, *registry_, externalRefs);
     }
 
-    std::string inputPath = argv[1];
-    std::string outputPath = argv[2];
-
-    std::string inputExt = inputPath.length() > 4 ? inputPath.substr(inputPath.size() - 4) : "";
-    std::string outputExt = outputPath.length() > 4 ? outputPath.substr(outputPath.size() - 4) : "";
-
-    try {
-        if (inputExt != ".bin" && inputExt != ".xml") throw std::runtime_error("Input file must be a .bin or .xml file");
-        if (outputExt != ".bin" && outputExt != ".xml") throw std::runtime_error("Output file must be a .bin or .xml file");
-
-        bool inputIsXml = (inputExt == ".xml");
-        bool outputIsXml = (outputExt == ".xml");
-
-        PhysXConverter converter;
-        if (!converter.InitPhysX()) {
-            std::cout << "Failed to initialize PhysX runtime" << std::endl;
-            return 1;
-        }
-
-        auto input = LoadFile(inputPath);
-
-        auto collection = inputIsXml ? converter.LoadCollectionFromXml(input) : converter.LoadCollectionFromBinary(input);
-        if (!collection) throw std::runtime_error("Unable to load resource collection from source file");
-
-        auto output = outputIsXml ? converter.SaveCollectionToXml(*collection) : converter.SaveCollectionToBinary(*collection);
-        WriteFile(outputPath, output);
-    } catch (std::exception& e) {
-        std::cout << e.what() << std::endl;
-        return 1;
-    }
+    KazMemoryOutputStream outStream;
+    if (!PxSerialization::serializeCollectionToBinaryDeterministic(outStream, collection, *registry_, externalRefs, true)) return {};
 
-    return 0;
+    return outStream.contents();
 }
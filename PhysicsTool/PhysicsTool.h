@@ -3,35 +3,155 @@
 #define _USE_MATH_DEFINES
 
 #include <vector>
+#include <string>
 #include <iostream>
 #include <fstream>
 #include <span>
+#include <memory>
+#include <unordered_map>
 
+#if defined(_WIN32)
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#else
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#define _stricmp strcasecmp
+#define _strdup strdup
+#endif
 
 
 #include <PxPhysicsAPI.h>
-#include <tinyxml.h>
+#include "MeshCache.h"
+#include "Fingerprint.h"
 
 using namespace physx;
 
+enum class CookedMeshType : uint8_t
+{
+    Convex,
+    Triangle
+};
+
+// Mesh that is cooked and inserted into the SDK before the actors referencing it are loaded
+struct MeshCookJob
+{
+    CookedMeshType Type{ CookedMeshType::Convex };
+    std::vector<PxVec3> Vertices;
+    // Triangle list; only used by triangle meshes
+    std::vector<PxU32> Indices;
+
+    std::vector<uint8_t> Cooked;
+    // Cooked data was read from the mesh cache rather than cooked in this run
+    bool FromCache{ false };
+    std::string Error;
+    PxConvexMesh* ConvexMesh{ nullptr };
+    PxTriangleMesh* TriangleMesh{ nullptr };
+};
+
+struct MaterialKey
+{
+    PxReal StaticFriction;
+    PxReal DynamicFriction;
+    PxReal Restitution;
+    uint32_t Flags;
+    uint32_t FrictionCombineMode;
+    uint32_t RestitutionCombineMode;
+
+    bool operator ==(MaterialKey const&) const = default;
+};
+
+struct MaterialKeyHash
+{
+    std::size_t operator()(MaterialKey const& key) const;
+};
+
+// Collection of deduplicated materials that other collections reference externally.
+// The serial object ID of each material is derived from its properties (XXH64 of MaterialKey),
+// so a material gets the same ID in every run, regardless of which inputs were converted and in
+// what order. A .bin written against one shared collection can be loaded against any later one
+// that still contains its materials.
+class SharedMaterials
+{
+public:
+    SharedMaterials(PxPhysics& physics);
+    ~SharedMaterials();
+
+    // Replaces the materials of all shapes in the collection with shared ones
+    // and removes the local copies from the collection
+    void Share(PxCollection& collection);
+
+    inline PxCollection& Collection()
+    {
+        return *collection_;
+    }
+
+    inline uint32_t NumShared() const
+    {
+        return (uint32_t)materials_.size();
+    }
+
+    inline uint32_t NumReplaced() const
+    {
+        return numReplaced_;
+    }
+
+private:
+    PxPhysics& physics_;
+    PxCollection* collection_;
+    std::unordered_map<MaterialKey, PxMaterial*, MaterialKeyHash> materials_;
+    uint32_t numReplaced_{ 0 };
+
+    PxMaterial* GetShared(PxMaterial& material);
+    PxSerialObjectId MakeSerialId(MaterialKey const& key) const;
+};
+
 class PhysXConverter
 {
 public:
     bool InitPhysX();
     void ShutdownPhysX();
 
-    PxCollection* LoadCollectionFromXml(std::span<uint8_t> const& xml);
-    PxCollection* LoadCollectionFromBinary(std::span<uint8_t> const& bin);
+    PxCollection* LoadCollectionFromXml(std::span<uint8_t const> xml);
+    // Objects the binary references externally are resolved from externalRefs, which must
+    // outlive the returned collection
+    PxCollection* LoadCollectionFromBinary(std::span<uint8_t const> bin, PxCollection* externalRefs = nullptr);
+    // Releases the collection and all objects in it
+    void ReleaseCollection(PxCollection* collection);
 
+    // XML output is self-contained; materials of external collections are written inline
     std::vector<uint8_t> SaveCollectionToXml(PxCollection& collection);
-    std::vector<uint8_t> SaveCollectionToBinary(PxCollection& collection);
+    std::vector<uint8_t> SaveCollectionToBinary(PxCollection& collection, PxCollection* externalRefs = nullptr);
+
+    std::unique_ptr<SharedMaterials> CreateSharedMaterials();
+
+    // Structural hash of the exported contents of the collection
+    uint64_t FingerprintCollection(PxCollection& collection);
+
+    // Changes whenever the same input converts to a different output; part of the manifest fingerprints
+    static constexpr uint64_t OutputVersion = 2;
+
+    void CookMeshes(std::vector<MeshCookJob>& jobs);
+
+    inline void SetMeshCache(MeshCache* cache)
+    {
+        meshCache_ = cache;
+    }
 
 private:
+    // Changes whenever the exporter output changes in a way that affects fingerprints
+    static constexpr uint64_t FingerprintVersion = 1;
+
     PxFoundation* foundation_{ nullptr };
     PxPhysics* physics_{ nullptr };
     PxCooking* cooking_{ nullptr };
     PxSerializationRegistry* registry_{ nullptr };
+    MeshCache* meshCache_{ nullptr };
+    std::unordered_map<PxCollection*, std::unique_ptr<uint8_t[]>> binaryBlocks_;
+
+    void CookMesh(MeshCookJob& job);
+    void CreateMesh(MeshCookJob& job);
+    std::string MeshCacheKey(MeshCookJob const& job) const;
 };
 
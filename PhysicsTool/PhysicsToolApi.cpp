@@ -0,0 +1,155 @@
+#include "PhysicsTool.h"
+#include "PhysicsToolApi.h"
+#include <mutex>
+
+// Only one PhysX foundation can exist per process, so all callers share one converter.
+// Conversions are serialized; mesh cooking is parallelized internally.
+static std::mutex gApiMutex;
+static PhysXConverter* gConverter{ nullptr };
+static std::unique_ptr<MeshCache> gMeshCache;
+static uint32_t gInitCount{ 0 };
+static thread_local std::string gLastError;
+
+
+PHYSICSTOOL_API int PhysicsToolInit()
+{
+    std::lock_guard<std::mutex> lock(gApiMutex);
+    if (gInitCount == 0) {
+        auto converter = new PhysXConverter();
+        if (!converter->InitPhysX()) {
+            delete converter;
+            gLastError = "Failed to initialize PhysX runtime";
+            return 0;
+        }
+
+        gConverter = converter;
+    }
+
+    gInitCount++;
+    return 1;
+}
+
+
+PHYSICSTOOL_API void PhysicsToolShutdown()
+{
+    std::lock_guard<std::mutex> lock(gApiMutex);
+    if (gInitCount == 0 || --gInitCount > 0) return;
+
+    gConverter->SetMeshCache(nullptr);
+    gMeshCache.reset();
+    gConverter->ShutdownPhysX();
+    delete gConverter;
+    gConverter = nullptr;
+}
+
+
+PHYSICSTOOL_API int PhysicsToolSetMeshCache(char const* path, uint64_t maxSize)
+{
+    std::lock_guard<std::mutex> lock(gApiMutex);
+    if (gConverter == nullptr) {
+        gLastError = "PhysX runtime is not initialized";
+        return 0;
+    }
+
+    try {
+        gConverter->SetMeshCache(nullptr);
+        gMeshCache.reset();
+        if (path != nullptr) {
+            gMeshCache = std::make_unique<MeshCache>(path, maxSize);
+            gConverter->SetMeshCache(gMeshCache.get());
+        }
+    } catch (std::exception& e) {
+        gLastError = e.what();
+        return 0;
+    }
+
+    return 1;
+}
+
+
+PHYSICSTOOL_API int PhysicsToolConvert(uint8_t const* input, size_t inputSize, int inputFormat,
+    int outputFormat, uint8_t** output, size_t* outputSize)
+{
+    return PhysicsToolConvertWithRefs(input, inputSize, inputFormat, outputFormat, nullptr, output, outputSize);
+}
+
+
+PHYSICSTOOL_API PhysicsToolExternalRefs* PhysicsToolLoadExternalRefs(uint8_t const* input, size_t inputSize)
+{
+    std::lock_guard<std::mutex> lock(gApiMutex);
+    if (gConverter == nullptr) {
+        gLastError = "PhysX runtime is not initialized";
+        return nullptr;
+    }
+
+    try {
+        auto collection = gConverter->LoadCollectionFromBinary(std::span<uint8_t const>(input, inputSize));
+        if (!collection) throw std::runtime_error("Unable to load external reference collection");
+        return reinterpret_cast<PhysicsToolExternalRefs*>(collection);
+    } catch (std::exception& e) {
+        gLastError = e.what();
+        return nullptr;
+    }
+}
+
+
+PHYSICSTOOL_API void PhysicsToolReleaseExternalRefs(PhysicsToolExternalRefs* refs)
+{
+    std::lock_guard<std::mutex> lock(gApiMutex);
+    if (gConverter == nullptr || refs == nullptr) return;
+
+    gConverter->ReleaseCollection(reinterpret_cast<PxCollection*>(refs));
+}
+
+
+PHYSICSTOOL_API int PhysicsToolConvertWithRefs(uint8_t const* input, size_t inputSize, int inputFormat,
+    int outputFormat, PhysicsToolExternalRefs* externalRefs, uint8_t** output, size_t* outputSize)
+{
+    std::lock_guard<std::mutex> lock(gApiMutex);
+    *output = nullptr;
+    *outputSize = 0;
+
+    if (gConverter == nullptr) {
+        gLastError = "PhysX runtime is not initialized";
+        return 0;
+    }
+
+    auto refs = reinterpret_cast<PxCollection*>(externalRefs);
+    PxCollection* collection{ nullptr };
+    try {
+        std::span<uint8_t const> in(input, inputSize);
+        collection = (inputFormat == PhysicsToolFormatXml)
+            ? gConverter->LoadCollectionFromXml(in)
+            : gConverter->LoadCollectionFromBinary(in, refs);
+        if (!collection) throw std::runtime_error("Unable to load resource collection from input");
+
+        auto out = (outputFormat == PhysicsToolFormatXml)
+            ? gConverter->SaveCollectionToXml(*collection)
+            : gConverter->SaveCollectionToBinary(*collection, refs);
+        if (out.empty()) throw std::runtime_error("Failed to serialize collection");
+
+        gConverter->ReleaseCollection(collection);
+        collection = nullptr;
+
+        *output = new uint8_t[out.size()];
+        memcpy(*output, out.data(), out.size());
+        *outputSize = out.size();
+        return 1;
+    } catch (std::exception& e) {
+        if (collection) gConverter->ReleaseCollection(collection);
+        gLastError = e.what();
+        return 0;
+    }
+}
+
+
+PHYSICSTOOL_API void PhysicsToolFree(uint8_t* buffer)
+{
+    delete[] buffer;
+}
+
+
+PHYSICSTOOL_API char const* PhysicsToolGetLastError()
+{
+    return gLastError.c_str();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(PHYSICSTOOL_EXPORTS)
+#define PHYSICSTOOL_API __declspec(dllexport)
+#else
+#define PHYSICSTOOL_API __declspec(dllimport)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum PhysicsToolFormat
+{
+    PhysicsToolFormatBinary = 0,
+    PhysicsToolFormatXml = 1
+};
+
+// Loaded binary collection whose objects other collections reference externally
+typedef struct PhysicsToolExternalRefs PhysicsToolExternalRefs;
+
+// Initializes the PhysX runtime. Calls are reference counted, each successful call
+// must be paired with a PhysicsToolShutdown() call. Returns 0 on failure.
+PHYSICSTOOL_API int PhysicsToolInit();
+PHYSICSTOOL_API void PhysicsToolShutdown();
+
+// Enables the on-disk cooked mesh cache (see MeshCache). Pass NULL to disable it.
+PHYSICSTOOL_API int PhysicsToolSetMeshCache(char const* path, uint64_t maxSize);
+
+// Converts a collection between binary and XML format. On success, returns nonzero and
+// stores a buffer in *output that must be released using PhysicsToolFree().
+// On failure, returns 0 and the reason can be queried using PhysicsToolGetLastError().
+PHYSICSTOOL_API int PhysicsToolConvert(uint8_t const* input, size_t inputSize, int inputFormat,
+    int outputFormat, uint8_t** output, size_t* outputSize);
+
+// Loads a binary collection that other collections were serialized against, e.g. the shared
+// material collection written by PhysicsTool --shared-materials. Returns NULL on failure.
+// Release using PhysicsToolReleaseExternalRefs() once no conversion uses it anymore.
+PHYSICSTOOL_API PhysicsToolExternalRefs* PhysicsToolLoadExternalRefs(uint8_t const* input, size_t inputSize);
+PHYSICSTOOL_API void PhysicsToolReleaseExternalRefs(PhysicsToolExternalRefs* refs);
+
+// Same as PhysicsToolConvert(), but binary inputs may reference objects of externalRefs.
+// Binary outputs keep referencing them; XML outputs contain a copy and are self-contained.
+PHYSICSTOOL_API int PhysicsToolConvertWithRefs(uint8_t const* input, size_t inputSize, int inputFormat,
+    int outputFormat, PhysicsToolExternalRefs* externalRefs, uint8_t** output, size_t* outputSize);
+PHYSICSTOOL_API void PhysicsToolFree(uint8_t* buffer);
+
+// Error message of the last failed call on the calling thread
+PHYSICSTOOL_API char const* PhysicsToolGetLastError();
+
+#ifdef __cplusplus
+}
+#endif
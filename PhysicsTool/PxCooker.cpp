@@ -0,0 +1,156 @@
+#include "PhysicsTool.h"
+#include <algorithm>
+#include <execution>
+
+template <class T>
+void AppendKey(std::string& key, T const& value)
+{
+    key.append(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+
+std::string PhysXConverter::MeshCacheKey(MeshCookJob const& job) const
+{
+    // Everything that affects the cooked output: SDK version, cooking parameters and mesh data
+    auto params = cooking_->getParams();
+
+    std::string key;
+    key.reserve(64 + job.Vertices.size() * sizeof(PxVec3) + job.Indices.size() * sizeof(PxU32));
+    AppendKey(key, (uint32_t)PX_PHYSICS_VERSION);
+    AppendKey(key, params.areaTestEpsilon);
+    AppendKey(key, params.planeTolerance);
+    AppendKey(key, (uint32_t)params.convexMeshCookingType);
+    AppendKey(key, params.suppressTriangleMeshRemapTable);
+    AppendKey(key, params.buildTriangleAdjacencies);
+    AppendKey(key, params.buildGPUData);
+    AppendKey(key, params.scale.length);
+    AppendKey(key, params.scale.speed);
+    AppendKey(key, (uint32_t)params.meshPreprocessParams);
+    AppendKey(key, params.meshWeldTolerance);
+    AppendKey(key, (uint32_t)params.midphaseDesc.getType());
+    if (params.midphaseDesc.getType() == PxMeshMidPhase::eBVH33) {
+        AppendKey(key, (uint32_t)params.midphaseDesc.mBVH33Desc.meshCookingHint);
+        AppendKey(key, params.midphaseDesc.mBVH33Desc.meshSizePerformanceTradeOff);
+    } else {
+        AppendKey(key, params.midphaseDesc.mBVH34Desc.numPrimsPerLeaf);
+    }
+    AppendKey(key, params.gaussMapLimit);
+    AppendKey(key, job.Type);
+    AppendKey(key, (uint64_t)job.Vertices.size());
+    key.append(reinterpret_cast<char const*>(job.Vertices.data()), job.Vertices.size() * sizeof(PxVec3));
+    key.append(reinterpret_cast<char const*>(job.Indices.data()), job.Indices.size() * sizeof(PxU32));
+    return key;
+}
+
+
+void PhysXConverter::CookMesh(MeshCookJob& job)
+{
+    std::string cacheKey;
+    if (meshCache_) {
+        cacheKey = MeshCacheKey(job);
+        job.FromCache = meshCache_->Get(cacheKey, job.Cooked);
+        if (job.FromCache) return;
+    }
+
+    PxDefaultMemoryOutputStream stream;
+
+    if (job.Type == CookedMeshType::Convex) {
+        PxConvexMeshDesc desc;
+        desc.points.count = (PxU32)job.Vertices.size();
+        desc.points.stride = sizeof(PxVec3);
+        desc.points.data = job.Vertices.data();
+        desc.flags = PxConvexFlag::eCOMPUTE_CONVEX;
+
+        PxConvexMeshCookingResult::Enum result;
+        if (!cooking_->cookConvexMesh(desc, stream, &result)) {
+            throw std::runtime_error("Failed to cook convex mesh (error " + std::to_string((int)result) + ")");
+        }
+    } else {
+        PxTriangleMeshDesc desc;
+        desc.points.count = (PxU32)job.Vertices.size();
+        desc.points.stride = sizeof(PxVec3);
+        desc.points.data = job.Vertices.data();
+        desc.triangles.count = (PxU32)(job.Indices.size() / 3);
+        desc.triangles.stride = 3 * sizeof(PxU32);
+        desc.triangles.data = job.Indices.data();
+
+        PxTriangleMeshCookingResult::Enum result;
+        if (!cooking_->cookTriangleMesh(desc, stream, &result)) {
+            throw std::runtime_error("Failed to cook triangle mesh (error " + std::to_string((int)result) + ")");
+        }
+    }
+
+    job.Cooked.assign(stream.getData(), stream.getData() + stream.getSize());
+
+    if (meshCache_) {
+        meshCache_->Put(cacheKey, job.Cooked);
+    }
+}
+
+
+void PhysXConverter::CookMeshes(std::vector<MeshCookJob>& jobs)
+{
+    // Cooking doesn't touch shared state, so distinct meshes are cooked concurrently;
+    // only the insertion of the cooked data into the SDK is done serially.
+    std::for_each(std::execution::par, jobs.begin(), jobs.end(), [this](MeshCookJob& job) {
+        try {
+            CookMesh(job);
+        } catch (std::exception& e) {
+            job.Error = e.what();
+        }
+    });
+
+    // Check all jobs first so nothing is created in the SDK if any of them failed
+    for (auto& job : jobs) {
+        if (!job.Error.empty()) throw std::runtime_error(job.Error);
+    }
+
+    for (auto& job : jobs) {
+        CreateMesh(job);
+
+        // A cached entry that passed validation but still can't be loaded is corrupt;
+        // evict it and cook the mesh again instead of failing the conversion
+        if (!job.ConvexMesh && !job.TriangleMesh && job.FromCache) {
+            meshCache_->Remove(MeshCacheKey(job));
+            try {
+                CookMesh(job);
+            } catch (std::exception& e) {
+                job.Error = e.what();
+            }
+
+            if (job.Error.empty()) {
+                CreateMesh(job);
+            }
+        }
+
+        if (!job.ConvexMesh && !job.TriangleMesh) {
+            // Release the meshes created so far; the converter outlives this collection
+            for (auto& created : jobs) {
+                if (created.ConvexMesh) created.ConvexMesh->release();
+                if (created.TriangleMesh) created.TriangleMesh->release();
+                created.ConvexMesh = nullptr;
+                created.TriangleMesh = nullptr;
+            }
+
+            if (!job.Error.empty()) throw std::runtime_error(job.Error);
+            throw std::runtime_error(job.Type == CookedMeshType::Convex
+                ? "Failed to create convex mesh from cooked data"
+                : "Failed to create triangle mesh from cooked data");
+        }
+    }
+
+    if (meshCache_) {
+        meshCache_->TrimIfNeeded();
+    }
+}
+
+
+void PhysXConverter::CreateMesh(MeshCookJob& job)
+{
+    PxDefaultMemoryInputData input(job.Cooked.data(), (PxU32)job.Cooked.size());
+    if (job.Type == CookedMeshType::Convex) {
+        job.ConvexMesh = physics_->createConvexMesh(input);
+    } else {
+        job.TriangleMesh = physics_->createTriangleMesh(input);
+    }
+}
@@ -1,121 +1,142 @@
 #include "PhysicsTool.h"
+#include "XmlStream.h"
+#include "Fingerprint.h"
 #include <unordered_map>
 
-#define PR(name, expr, def) {auto _v = (expr); if (ExportAllProperties || !(_v == (def))) { ExportProperty(ele, #name, _v); }}
-#define P(name, expr) ExportProperty(ele, #name, (expr))
-#define P_BOUNDED(name, expr, bound) {auto _v = (expr); if (ExportAllProperties || _v >= (bound)) { if (_v < bound) ExportProperty(ele, #name, _v); else ExportProperty(ele, #name, "Unbounded"); }}
-#define PFLAG(name, expr, flag) {auto _v = (expr); if (ExportAllProperties || (_v & flag) == flag) { ExportProperty(ele, #name, (_v & flag) == flag); }}
+#define PR(name, expr, def) {auto _v = (expr); if (ExportAllProperties || !(_v == (def))) { ExportProperty(#name, _v); }}
+#define P(name, expr) ExportProperty(#name, (expr))
+#define P_BOUNDED(name, expr, bound) {auto _v = (expr); if (ExportAllProperties || _v >= (bound)) { if (_v < bound) ExportProperty(#name, _v); else ExportProperty(#name, "Unbounded"); }}
+#define PFLAG(name, expr, flag) {auto _v = (expr); if (ExportAllProperties || (_v & flag) == flag) { ExportProperty(#name, (_v & flag) == flag); }}
 
 class PhysXExporter
 {
 public:
     bool ExportAllProperties{ true };
     std::unordered_map<PxMaterial*, uint32_t> materials_;
+    XmlStreamWriter writer_;
 
-    TiXmlDocument* Export(PxCollection& collection)
+    PhysXExporter(std::size_t reserveSize)
+        : writer_(reserveSize)
+    {}
+
+    void HashOnly(XxHash64& hash)
+    {
+        writer_.HashOnly(hash);
+    }
+
+    std::vector<uint8_t> Export(PxCollection& collection)
     {
-        auto doc = new TiXmlDocument();
-        doc->InsertEndChild(TiXmlDeclaration("1.0", "UTF-8", ""));
-        auto root = doc->InsertEndChild(TiXmlElement("BG3Physics"));
+        writer_.WriteDeclaration();
+        writer_.BeginElement("BG3Physics");
+
+        // Shapes of collections loaded against external references may use materials that aren't
+        // in the collection; write them first so the document can be loaded on its own
+        for (uint32_t i = 0; i < collection.getNbObjects(); i++) {
+            if (auto shape = collection.getObject(i).is<PxShape>()) {
+                PxMaterial* material;
+                if (shape->getMaterials(&material, 1, 0) == 1 && !collection.contains(*material)) {
+                    Export(*material);
+                }
+            }
+        }
 
         for (uint32_t i = 0; i < collection.getNbObjects(); i++) {
             auto& obj = collection.getObject(i);
-            ExportTopLevel(*root, obj);
+            ExportTopLevel(obj);
         }
 
-        return doc;
+        writer_.EndElement();
+        return writer_.Release();
     }
 
     template <class T>
-    void ExportProperty(TiXmlNode& ele, char const* name, T value)
+    void ExportProperty(char const* name, T value)
     {
-        auto& prop = *ele.InsertEndChild(TiXmlElement(name));
-        prop.InsertEndChild(TiXmlText(std::to_string(value)));
+        writer_.WriteInteger(name, (uint64_t)value);
     }
 
     template <>
-    void ExportProperty<bool>(TiXmlNode& ele, char const* name, bool obj)
+    void ExportProperty<bool>(char const* name, bool obj)
     {
-        auto& prop = *ele.InsertEndChild(TiXmlElement(name));
-        prop.InsertEndChild(TiXmlText(obj ? "true" : "false"));
+        writer_.WriteElement(name, obj ? "true" : "false");
     }
 
     template <>
-    void ExportProperty<PxReal>(TiXmlNode& ele, char const* name, PxReal obj)
+    void ExportProperty<PxReal>(char const* name, PxReal obj)
     {
-        auto& prop = *ele.InsertEndChild(TiXmlElement(name));
-        char val[32];
-        std::snprintf(val, sizeof(val), "%.8f", obj);
-        prop.InsertEndChild(TiXmlText(val));
+        writer_.WriteReal(name, obj);
     }
 
     template <>
-    void ExportProperty<char const*>(TiXmlNode& ele, char const* name, char const* obj)
+    void ExportProperty<char const*>(char const* name, char const* obj)
     {
-        auto& prop = *ele.InsertEndChild(TiXmlElement(name));
-        prop.InsertEndChild(TiXmlText(obj));
+        writer_.WriteElement(name, obj ? obj : "");
     }
 
     template <>
-    void ExportProperty<PxVec3>(TiXmlNode& parent, char const* name, PxVec3 obj)
+    void ExportProperty<PxVec3>(char const* name, PxVec3 obj)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement(name));
+        writer_.BeginElement(name);
         PR(X, obj.x, 0.0f);
         PR(Y, obj.y, 0.0f);
         PR(Z, obj.z, 0.0f);
+        writer_.EndElement();
     }
 
     template <>
-    void ExportProperty<PxQuat>(TiXmlNode& parent, char const* name, PxQuat obj)
+    void ExportProperty<PxQuat>(char const* name, PxQuat obj)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement(name));
+        writer_.BeginElement(name);
         PR(X, obj.x, 0.0f);
         PR(Y, obj.y, 0.0f);
         PR(Z, obj.z, 0.0f);
         PR(W, obj.w, 1.0f);
+        writer_.EndElement();
     }
 
     template <>
-    void ExportProperty<PxTransform>(TiXmlNode& parent, char const* name, PxTransform obj)
+    void ExportProperty<PxTransform>(char const* name, PxTransform obj)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement(name));
+        writer_.BeginElement(name);
         PR(Position, obj.p, PxVec3());
         PR(Rotation, obj.q, PxQuat());
+        writer_.EndElement();
     }
 
     template <>
-    void ExportProperty<PxMeshScale>(TiXmlNode& parent, char const* name, PxMeshScale obj)
+    void ExportProperty<PxMeshScale>(char const* name, PxMeshScale obj)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement(name));
+        writer_.BeginElement(name);
         PR(Scale, obj.scale, PxVec3());
         PR(Rotation, obj.rotation, PxQuat());
+        writer_.EndElement();
     }
 
     template <>
-    void ExportProperty<PxJointLinearLimit>(TiXmlNode& parent, char const* name, PxJointLinearLimit obj)
+    void ExportProperty<PxJointLinearLimit>(char const* name, PxJointLinearLimit obj)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement(name));
+        writer_.BeginElement(name);
         P_BOUNDED(Value, obj.value, 3.4e+37f); // PX_MAX_F32
         PR(Restitution, obj.restitution, 0.0f);
         PR(BounceThreshold, obj.bounceThreshold, 0.0f);
         PR(Stiffness, obj.stiffness, 0.0f);
         PR(Damping, obj.damping, 0.0f);
         PR(ContactDistance, obj.contactDistance, 0.0f);
+        writer_.EndElement();
     }
 
     template <>
-    void ExportProperty<PxD6Motion::Enum>(TiXmlNode& parent, char const* name, PxD6Motion::Enum obj)
+    void ExportProperty<PxD6Motion::Enum>(char const* name, PxD6Motion::Enum obj)
     {
         constexpr char const* kNames[] = {"Locked", "Limited", "Free"};
 
-        auto& prop = *parent.InsertEndChild(TiXmlElement(name));
-        prop.InsertEndChild(TiXmlText(kNames[(uint32_t)obj]));
+        writer_.WriteElement(name, kNames[(uint32_t)obj]);
     }
 
     template <>
-    void ExportProperty<PxJointLinearLimitPair>(TiXmlNode& parent, char const* name, PxJointLinearLimitPair obj)
+    void ExportProperty<PxJointLinearLimitPair>(char const* name, PxJointLinearLimitPair obj)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement(name));
+        writer_.BeginElement(name);
         PR(Lower, obj.lower, -PX_MAX_F32/3);
         PR(Upper, obj.upper, PX_MAX_F32/3);
         PR(Restitution, obj.restitution, 0.0f);
@@ -123,12 +144,13 @@ public:
         PR(Stiffness, obj.stiffness, 0.0f);
         PR(Damping, obj.damping, 0.0f);
         PR(ContactDistance, obj.contactDistance, 0.0f);
+        writer_.EndElement();
     }
 
     template <>
-    void ExportProperty<PxJointAngularLimitPair>(TiXmlNode& parent, char const* name, PxJointAngularLimitPair obj)
+    void ExportProperty<PxJointAngularLimitPair>(char const* name, PxJointAngularLimitPair obj)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement(name));
+        writer_.BeginElement(name);
         PR(Lower, obj.lower, -(float)M_PI/2.0f);
         PR(Upper, obj.upper, (float)M_PI/2.0f);
         PR(Restitution, obj.restitution, 0.0f);
@@ -136,12 +158,13 @@ public:
         PR(Stiffness, obj.stiffness, 0.0f);
         PR(Damping, obj.damping, 0.0f);
         PR(ContactDistance, obj.contactDistance, 0.0f);
+        writer_.EndElement();
     }
 
     template <>
-    void ExportProperty<PxJointLimitCone>(TiXmlNode& parent, char const* name, PxJointLimitCone obj)
+    void ExportProperty<PxJointLimitCone>(char const* name, PxJointLimitCone obj)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement(name));
+        writer_.BeginElement(name);
         PR(YAngle, obj.yAngle, (float)M_PI/2.0f);
         PR(ZAngle, obj.zAngle, (float)M_PI/2.0f);
         PR(Restitution, obj.restitution, 0.0f);
@@ -149,12 +172,13 @@ public:
         PR(Stiffness, obj.stiffness, 0.0f);
         PR(Damping, obj.damping, 0.0f);
         PR(ContactDistance, obj.contactDistance, 0.0f);
+        writer_.EndElement();
     }
 
     template <>
-    void ExportProperty<PxJointLimitPyramid>(TiXmlNode& parent, char const* name, PxJointLimitPyramid obj)
+    void ExportProperty<PxJointLimitPyramid>(char const* name, PxJointLimitPyramid obj)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement(name));
+        writer_.BeginElement(name);
         PR(YAngleMin, obj.yAngleMin, -(float)M_PI/2.0f);
         PR(YAngleMax, obj.yAngleMax, (float)M_PI/2.0f);
         PR(ZAngleMin, obj.zAngleMin, -(float)M_PI/2.0f);
@@ -164,19 +188,21 @@ public:
         PR(Stiffness, obj.stiffness, 0.0f);
         PR(Damping, obj.damping, 0.0f);
         PR(ContactDistance, obj.contactDistance, 0.0f);
+        writer_.EndElement();
     }
 
     template <>
-    void ExportProperty<PxD6JointDrive>(TiXmlNode& parent, char const* name, PxD6JointDrive obj)
+    void ExportProperty<PxD6JointDrive>(char const* name, PxD6JointDrive obj)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement(name));
+        writer_.BeginElement(name);
         P_BOUNDED(ForceLimit, obj.forceLimit, 3.4e+37f); // PX_MAX_F32
         PFLAG(IsAcceleration, obj.flags, PxD6JointDriveFlag::eACCELERATION);
         PR(Stiffness, obj.stiffness, 0.0f);
         PR(Damping, obj.damping, 0.0f);
+        writer_.EndElement();
     }
 
-    void Export(TiXmlNode& parent, PxMaterial& obj)
+    void Export(PxMaterial& obj)
     {
         auto it = materials_.find(&obj);
         if (it != materials_.end()) return;
@@ -184,62 +210,64 @@ public:
         auto index = (PxU32)materials_.size();
         materials_.insert(std::make_pair(&obj, index));
 
-        auto& ele = *parent.InsertEndChild(TiXmlElement("Material"));
+        writer_.BeginElement("Material");
 
         P(Index, index);
         PR(StaticFriction, obj.getStaticFriction(), 1.0f);
         PR(DynamicFriction, obj.getDynamicFriction(), 1.0f);
         PR(Restitution, obj.getRestitution(), 0.0f);
+
+        writer_.EndElement();
     }
 
-    void ExportProperties(TiXmlNode& ele, PxSphereGeometry& o)
+    void ExportProperties(PxSphereGeometry& o)
     {
-        ExportProperty(ele, "Type", "Sphere");
-        ExportProperty(ele, "Radius", o.radius);
+        ExportProperty("Type", "Sphere");
+        ExportProperty("Radius", o.radius);
     }
 
-    void ExportProperties(TiXmlNode& ele, PxCapsuleGeometry& o)
+    void ExportProperties(PxCapsuleGeometry& o)
     {
-        ExportProperty(ele, "Type", "Capsule");
-        ExportProperty(ele, "Radius", o.radius);
-        ExportProperty(ele, "HalfHeight", o.halfHeight);
+        ExportProperty("Type", "Capsule");
+        ExportProperty("Radius", o.radius);
+        ExportProperty("HalfHeight", o.halfHeight);
     }
 
-    void ExportProperties(TiXmlNode& ele, PxBoxGeometry& o)
+    void ExportProperties(PxBoxGeometry& o)
     {
-        ExportProperty(ele, "Type", "Box");
-        ExportProperty(ele, "HalfExtents", o.halfExtents);
+        ExportProperty("Type", "Box");
+        ExportProperty("HalfExtents", o.halfExtents);
     }
 
-    void ExportProperties(TiXmlNode& ele, PxConvexMeshGeometry& o)
+    void ExportProperties(PxConvexMeshGeometry& o)
     {
-        ExportProperty(ele, "Type", "ConvexMesh");
-        ExportProperty(ele, "Scale", o.scale);
+        ExportProperty("Type", "ConvexMesh");
+        ExportProperty("Scale", o.scale);
         // s << "\t" "MeshFlags: " << (uint32_t)o.meshFlags << std::endl; - Always 0
 
-        Export(ele, *o.convexMesh);
+        Export(*o.convexMesh);
     }
 
-    void ExportProperties(TiXmlNode& ele, PxTriangleMeshGeometry& o)
+    void ExportProperties(PxTriangleMeshGeometry& o)
     {
-        ExportProperty(ele, "Type", "TriangleMesh");
-        ExportProperty(ele, "Scale", o.scale);
+        ExportProperty("Type", "TriangleMesh");
+        ExportProperty("Scale", o.scale);
         // s << "\t" "MeshFlags: " << (uint32_t)o.meshFlags << std::endl; - Always 0
 
-        Export(ele, *o.triangleMesh);
+        Export(*o.triangleMesh);
     }
 
-    void Export(TiXmlNode& parent, PxGeometry& o)
+    void Export(PxGeometry& o)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement("Geometry"));
+        writer_.BeginElement("Geometry");
 
         switch (o.getType())
         {
-        case PxGeometryType::eSPHERE: ExportProperties(ele, static_cast<PxSphereGeometry&>(o)); break;
-        case PxGeometryType::eCAPSULE: ExportProperties(ele, static_cast<PxCapsuleGeometry&>(o)); break;
-        case PxGeometryType::eBOX: ExportProperties(ele, static_cast<PxBoxGeometry&>(o)); break;
-        case PxGeometryType::eCONVEXMESH: ExportProperties(ele, static_cast<PxConvexMeshGeometry&>(o)); break;
-        case PxGeometryType::eTRIANGLEMESH: ExportProperties(ele, static_cast<PxTriangleMeshGeometry&>(o)); break;
+        case PxGeometryType::eSPHERE: ExportProperties(static_cast<PxSphereGeometry&>(o)); break;
+        case PxGeometryType::eCAPSULE: ExportProperties(static_cast<PxCapsuleGeometry&>(o)); break;
+        case PxGeometryType::eBOX: ExportProperties(static_cast<PxBoxGeometry&>(o)); break;
+        case PxGeometryType::eCONVEXMESH: ExportProperties(static_cast<PxConvexMeshGeometry&>(o)); break;
+        case PxGeometryType::eTRIANGLEMESH: ExportProperties(static_cast<PxTriangleMeshGeometry&>(o)); break;
 
         case PxGeometryType::ePLANE:
         case PxGeometryType::eHEIGHTFIELD:
@@ -247,11 +275,13 @@ public:
             std::cout << "WARNING: Unsupported geometry type: " << o.getType() << std::endl;
             break;
         }
+
+        writer_.EndElement();
     }
 
-    void Export(TiXmlNode& parent, PxShape& o)
+    void Export(PxShape& o)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement("Shape"));
+        writer_.BeginElement("Shape");
 
         if (o.getNbMaterials() != 1) {
             throw std::runtime_error("Only 1 material per shape is supported");
@@ -262,7 +292,7 @@ public:
         auto matIt = materials_.find(material);
         if (matIt == materials_.end()) throw std::runtime_error("Shape references unknown material object");
 
-        ExportProperty(ele, "Name", o.getName());
+        ExportProperty("Name", o.getName());
         P(MaterialIndex, matIt->second);
         PR(LocalPose, o.getLocalPose(), PxTransform());
         PR(ContactOffset, o.getContactOffset(), 0.02f);
@@ -270,12 +300,13 @@ public:
         PR(TorsionalPatchRadius, o.getTorsionalPatchRadius(), 0.0f);
         PR(MinTorsionalPatchRadius, o.getMinTorsionalPatchRadius(), 0.0f);
 
-        Export(ele, o.getGeometry().any());
+        Export(o.getGeometry().any());
+        writer_.EndElement();
     }
 
-    void ExportProperties(TiXmlNode& ele, PxRigidActor& o)
+    void ExportProperties(PxRigidActor& o)
     {
-        ExportProperty(ele, "Name", o.getName());
+        ExportProperty("Name", o.getName());
 
         PR(GlobalPose, o.getGlobalPose(), PxTransform());
         PFLAG(DisableGravity, o.getActorFlags(), PxActorFlag::eDISABLE_GRAVITY);
@@ -285,10 +316,11 @@ public:
         shapes.resize(o.getNbShapes());
         o.getShapes(shapes.data(), (uint32_t)shapes.size(), 0);
         if (!shapes.empty()) {
-            auto& shapesEle = *ele.InsertEndChild(TiXmlElement("Shapes"));
+            writer_.BeginElement("Shapes");
             for (auto shape : shapes) {
-                Export(shapesEle, *shape);
+                Export(*shape);
             }
+            writer_.EndElement();
         }
 
         // These should be handled by the joint, not the rigidbody
@@ -304,15 +336,16 @@ public:
         }*/
     }
 
-    void Export(TiXmlNode& parent, PxRigidStatic& o)
+    void Export(PxRigidStatic& o)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement("RigidStatic"));
-        ExportProperties(ele, static_cast<PxRigidActor&>(o));
+        writer_.BeginElement("RigidStatic");
+        ExportProperties(static_cast<PxRigidActor&>(o));
+        writer_.EndElement();
     }
 
-    void ExportProperties(TiXmlNode& ele, PxRigidBody& o)
+    void ExportProperties(PxRigidBody& o)
     {
-        ExportProperties(ele, static_cast<PxRigidActor&>(o));
+        ExportProperties(static_cast<PxRigidActor&>(o));
 
         PR(CMassLocalPose, o.getCMassLocalPose(), PxTransform());
         PR(Mass, o.getMass(), 1.0f);
@@ -336,10 +369,10 @@ public:
         P_BOUNDED(MaxContactImpulse, o.getMaxContactImpulse(), 1e+31f); // 1e+32f
     }
 
-    void Export(TiXmlNode& parent, PxRigidDynamic& o)
+    void Export(PxRigidDynamic& o)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement("RigidDynamic"));
-        ExportProperties(ele, static_cast<PxRigidBody&>(o));
+        writer_.BeginElement("RigidDynamic");
+        ExportProperties(static_cast<PxRigidBody&>(o));
 
         PxU32 minPositionIters, minVelocityIters;
         o.getSolverIterationCounts(minPositionIters, minVelocityIters);
@@ -358,12 +391,14 @@ public:
         P_BOUNDED(ContactReportThreshold, o.getContactReportThreshold(), 3.40282e+37f); // PX_MAX_F32
         PR(MinPositionIters, minPositionIters, 4);
         PR(MinVelocityIters, minVelocityIters, 1);
+
+        writer_.EndElement();
     }
 
-    void Export(TiXmlNode& parent, PxD6Joint& o)
+    void Export(PxD6Joint& o)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement("D6Joint"));
-        ExportProperties(ele, static_cast<PxJoint&>(o));
+        writer_.BeginElement("D6Joint");
+        ExportProperties(static_cast<PxJoint&>(o));
 
         PR(MotionX, o.getMotion(PxD6Axis::eX), PxD6Motion::eFREE);
         PR(MotionY, o.getMotion(PxD6Axis::eY), PxD6Motion::eFREE);
@@ -389,17 +424,19 @@ public:
 
         PR(ProjectionLinearTolerance, o.getProjectionLinearTolerance(), 1e+10f);
         PR(ProjectionAngularTolerance, o.getProjectionAngularTolerance(), 3.14159f);
+
+        writer_.EndElement();
     }
 
-    void ExportProperties(TiXmlNode& ele, PxJoint& o)
+    void ExportProperties(PxJoint& o)
     {
-        ExportProperty(ele, "Name", o.getName());
+        ExportProperty("Name", o.getName());
 
         PxRigidActor* actor0 = nullptr, * actor1 = nullptr;
         o.getActors(actor0, actor1);
 
-        if (actor0) ExportProperty(ele, "Actor0", actor0->getName());
-        if (actor1) ExportProperty(ele, "Actor1", actor1->getName());
+        if (actor0) ExportProperty("Actor0", actor0->getName());
+        if (actor1) ExportProperty("Actor1", actor1->getName());
 
         PR(Actor0LocalPose, o.getLocalPose(PxJointActorIndex::eACTOR0), PxTransform());
         PR(Actor1LocalPose, o.getLocalPose(PxJointActorIndex::eACTOR1), PxTransform());
@@ -420,10 +457,10 @@ public:
         PR(InvInertiaScale1, o.getInvInertiaScale1(), 1.0f);
     }
 
-    void Export(TiXmlNode& parent, PxArticulationJoint& o)
+    void Export(PxArticulationJoint& o)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement("Joint"));
-        ExportProperties(ele, static_cast<PxArticulationJointBase&>(o));
+        writer_.BeginElement("Joint");
+        ExportProperties(static_cast<PxArticulationJointBase&>(o));
 
         PR(Stiffness, o.getStiffness(), 0.0f);
         PR(Damping, o.getDamping(), 0.0f);
@@ -447,23 +484,25 @@ public:
 
         PR(TwistLimitContactDistance, o.getTwistLimitContactDistance(), 0.05f);
         PR(TwistLimitEnabled, o.getTwistLimitEnabled(), false);
+
+        writer_.EndElement();
     }
 
-    void ExportProperties(TiXmlNode& ele, PxArticulationJointBase& o)
+    void ExportProperties(PxArticulationJointBase& o)
     {
         PR(ParentPose, o.getParentPose(), PxTransform());
         PR(ChildPose, o.getChildPose(), PxTransform());
     }
 
-    void Export(TiXmlNode& parent, PxArticulationLink& o)
+    void Export(PxArticulationLink& o)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement("Link"));
-        ExportProperties(ele, static_cast<PxRigidBody&>(o));
+        writer_.BeginElement("Link");
+        ExportProperties(static_cast<PxRigidBody&>(o));
 
         auto joint = o.getInboundJoint();
         if (joint != nullptr) {
             PR(InboundJointDof, o.getInboundJointDof(), 0);
-            Export(ele, static_cast<PxArticulationJoint&>(*joint));
+            Export(static_cast<PxArticulationJoint&>(*joint));
         }
 
         if (o.getNbChildren() > 0) {
@@ -471,26 +510,32 @@ public:
             children.resize(o.getNbChildren());
             o.getChildren(children.data(), (PxU32)children.size(), 0);
 
-            auto& childrenEle = *ele.InsertEndChild(TiXmlElement("Links"));
+            writer_.BeginElement("Links");
 
             for (auto child : children) {
-                Export(childrenEle, *child);
+                Export(*child);
             }
+
+            writer_.EndElement();
         }
+
+        writer_.EndElement();
     }
 
-    void Export(TiXmlNode& parent, PxArticulation& o)
+    void Export(PxArticulation& o)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement("Articulation"));
-        ExportProperties(ele, static_cast<PxArticulationBase&>(o));
+        writer_.BeginElement("Articulation");
+        ExportProperties(static_cast<PxArticulationBase&>(o));
 
         PR(MaxProjectionIterations, o.getMaxProjectionIterations(), 4);
         PR(SeparationTolerance, o.getSeparationTolerance(), 0.01f);
         PR(InternalDriveIterations, o.getInternalDriveIterations(), 4);
         PR(ExternalDriveIterations, o.getExternalDriveIterations(), 4);
+
+        writer_.EndElement();
     }
 
-    void ExportProperties(TiXmlNode& ele, PxArticulationBase& o)
+    void ExportProperties(PxArticulationBase& o)
     {
         PR(SleepThreshold, o.getSleepThreshold(), 0.005f);
         PR(StabilizationThreshold, o.getStabilizationThreshold(), 0.0025f);
@@ -501,19 +546,21 @@ public:
             children.resize(o.getNbLinks());
             o.getLinks(children.data(), (PxU32)children.size(), 0);
 
-            auto& childrenEle = *ele.InsertEndChild(TiXmlElement("Links"));
+            writer_.BeginElement("Links");
 
             for (auto child : children) {
                 if (child->getInboundJoint() == nullptr) {
-                    Export(childrenEle, *child);
+                    Export(*child);
                 }
             }
+
+            writer_.EndElement();
         }
     }
 
-    void Export(TiXmlNode& parent, PxConvexMesh& o)
+    void Export(PxConvexMesh& o)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement("ConvexMesh"));
+        writer_.BeginElement("ConvexMesh");
 
         auto verts = o.getVertices();
         auto inds = o.getIndexBuffer();
@@ -523,37 +570,45 @@ public:
             PxHullPolygon poly;
             o.getPolygonData(i, poly);
 
-            auto& polyEle = *ele.InsertEndChild(TiXmlElement("Polygon"));
+            writer_.BeginElement("Polygon");
 
             for (PxU32 v = 0; v < poly.mNbVerts; v++) {
                 auto vert = verts[inds[poly.mIndexBase + v]];
-                ExportProperty(polyEle, "Vertex", vert);
+                ExportProperty("Vertex", vert);
             }
+
+            writer_.EndElement();
         }
+
+        writer_.EndElement();
     }
 
-    void Export(TiXmlNode& parent, PxTriangleMesh& o)
+    void Export(PxTriangleMesh& o)
     {
-        auto& ele = *parent.InsertEndChild(TiXmlElement("TriangleMesh"));
+        writer_.BeginElement("TriangleMesh");
 
         auto verts = o.getVertices();
-        auto inds = (PxU16*)o.getTriangles();
         auto tris = o.getNbTriangles();
+        auto inds16 = (PxU16 const*)o.getTriangles();
+        auto inds32 = (PxU32 const*)o.getTriangles();
+        bool has16BitIndices = o.getTriangleMeshFlags() & PxTriangleMeshFlag::e16_BIT_INDICES;
 
         for (PxU32 i = 0; i < tris*3; i++) {
-            auto vert = verts[inds[i]];
-            ExportProperty(ele, "Vertex", vert);
+            auto vert = verts[has16BitIndices ? inds16[i] : inds32[i]];
+            ExportProperty("Vertex", vert);
         }
+
+        writer_.EndElement();
     }
 
-    void ExportTopLevel(TiXmlNode& parent, PxBase& obj)
+    void ExportTopLevel(PxBase& obj)
     {
         switch (obj.getConcreteType()) {
-        case PxTypeInfo<PxMaterial>::eFastTypeId: return Export(parent, static_cast<PxMaterial&>(obj));
-        case PxTypeInfo<PxRigidStatic>::eFastTypeId: Export(parent, static_cast<PxRigidStatic&>(obj)); break;
-        case PxTypeInfo<PxRigidDynamic>::eFastTypeId: Export(parent, static_cast<PxRigidDynamic&>(obj)); break;
-        case PxTypeInfo<PxD6Joint>::eFastTypeId: Export(parent, static_cast<PxD6Joint&>(obj)); break;
-        case PxTypeInfo<PxArticulation>::eFastTypeId: Export(parent, static_cast<PxArticulation&>(obj)); break;
+        case PxTypeInfo<PxMaterial>::eFastTypeId: return Export(static_cast<PxMaterial&>(obj));
+        case PxTypeInfo<PxRigidStatic>::eFastTypeId: Export(static_cast<PxRigidStatic&>(obj)); break;
+        case PxTypeInfo<PxRigidDynamic>::eFastTypeId: Export(static_cast<PxRigidDynamic&>(obj)); break;
+        case PxTypeInfo<PxD6Joint>::eFastTypeId: Export(static_cast<PxD6Joint&>(obj)); break;
+        case PxTypeInfo<PxArticulation>::eFastTypeId: Export(static_cast<PxArticulation&>(obj)); break;
 
         // These are child nodes of other types and will be exported alongside them
         case PxTypeInfo<PxShape>::eFastTypeId:
@@ -562,6 +617,7 @@ public:
         case PxTypeInfo<PxArticulationLink>::eFastTypeId:
         case PxTypeInfo<PxConvexMesh>::eFastTypeId:
         case PxTypeInfo<PxBVH33TriangleMesh>::eFastTypeId:
+        case PxTypeInfo<PxBVH34TriangleMesh>::eFastTypeId:
             return;
 
         default:
@@ -573,9 +629,18 @@ public:
 
 std::vector<uint8_t> PhysXConverter::SaveCollectionToXml(PxCollection& collection)
 {
-    PhysXExporter exporter;
-    auto xml = exporter.Export(collection);
-    TiXmlPrinter printer;
-    xml->Accept(&printer);
-    return std::vector<uint8_t>((uint8_t const*)printer.Str().data(), (uint8_t const*)printer.Str().data() + printer.Str().size());;
+    // Rough estimate of the output size to avoid most buffer reallocations
+    PhysXExporter exporter(0x1000 + (std::size_t)collection.getNbObjects() * 0x400);
+    return exporter.Export(collection);
+}
+
+uint64_t PhysXConverter::FingerprintCollection(PxCollection& collection)
+{
+    // Hash the markup the XML exporter would produce; this covers exactly the objects and
+    // properties that are exported, and doesn't depend on the format the collection came from
+    XxHash64 hash(FingerprintVersion);
+    PhysXExporter exporter(0);
+    exporter.HashOnly(hash);
+    exporter.Export(collection);
+    return hash.Digest();
 }
@@ -1,4 +1,7 @@
 #include "PhysicsTool.h"
+#include "XmlStream.h"
+#include <charconv>
+#include <cstring>
 #include <unordered_map>
 
 #define PR(name, type, def) LoadProperty<type>(ele, #name, def)
@@ -14,6 +17,7 @@
 class PhysXLoader
 {
 public:
+    PhysXConverter* converter_;
     PxPhysics* physics_;
     PxCooking* cooking_;
 
@@ -22,11 +26,163 @@ public:
     std::unordered_map<uint32_t, PxMaterial*> materials_;
     std::unordered_map<std::string, PxRigidActor*> actors_;
 
-    PxCollection* Load(TiXmlElement& doc)
+    // Distinct meshes in the document, keyed by their type and vertex/index data
+    std::vector<MeshCookJob> meshes_;
+    std::unordered_map<std::string, std::size_t> meshIndex_;
+    // Mesh of each Geometry element, keyed by the position of the element in the source document.
+    // Element names point into the document, so the key is the same in both passes.
+    std::unordered_map<char const*, std::size_t> geometryMeshes_;
+
+    struct VertexHash
+    {
+        std::size_t operator()(PxVec3 const& v) const
+        {
+            std::hash<PxReal> h;
+            return h(v.x) ^ (h(v.y) << 1) ^ (h(v.z) << 2);
+        }
+    };
+
+    // Collects every mesh referenced by the document and cooks them in one batch.
+    // This needs a separate pass as actors are loaded one at a time and their shapes
+    // must be created with a finished mesh.
+    void CookMeshes(std::span<uint8_t const> xml)
+    {
+        std::string_view doc(reinterpret_cast<char const*>(xml.data()), xml.size());
+        if (doc.find("<ConvexMesh") == std::string_view::npos
+            && doc.find("<TriangleMesh") == std::string_view::npos) {
+            return;
+        }
+
+        XmlStreamReader reader(xml);
+        reader.ReadRootElement();
+        while (auto child = reader.ReadNextElement()) {
+            CollectMeshes(*child);
+        }
+
+        converter_->CookMeshes(meshes_);
+    }
+
+    void CollectMeshes(XmlElement& ele)
+    {
+        if (ele.ValueStr() == "Geometry") {
+            MeshCookJob job;
+            if (ReadMesh(ele, job)) {
+                auto key = MeshKey(job);
+                auto it = meshIndex_.find(key);
+                if (it == meshIndex_.end()) {
+                    it = meshIndex_.insert(std::make_pair(std::move(key), meshes_.size())).first;
+                    meshes_.push_back(std::move(job));
+                }
+
+                geometryMeshes_[ele.Name.data()] = it->second;
+            }
+            return;
+        }
+
+        for (auto child = ele.FirstChildElement(); child; child = child->NextSiblingElement()) {
+            CollectMeshes(*child);
+        }
+    }
+
+    bool ReadMesh(XmlElement& geomEle, MeshCookJob& job)
+    {
+        if (auto meshEle = geomEle.FirstChildElement("ConvexMesh")) {
+            // Polygons share vertices; the hull is recomputed from the distinct points
+            job.Type = CookedMeshType::Convex;
+            std::unordered_map<PxVec3, PxU32, VertexHash> vertexMap;
+            for (auto poly = meshEle->FirstChildElement("Polygon"); poly; poly = poly->NextSiblingElement("Polygon")) {
+                for (auto vert = poly->FirstChildElement("Vertex"); vert; vert = vert->NextSiblingElement("Vertex")) {
+                    AddVertex(job, vertexMap, LoadVertex(*vert));
+                }
+            }
+
+            job.Indices.clear();
+            return true;
+        } else if (auto meshEle = geomEle.FirstChildElement("TriangleMesh")) {
+            job.Type = CookedMeshType::Triangle;
+            std::unordered_map<PxVec3, PxU32, VertexHash> vertexMap;
+            for (auto vert = meshEle->FirstChildElement("Vertex"); vert; vert = vert->NextSiblingElement("Vertex")) {
+                AddVertex(job, vertexMap, LoadVertex(*vert));
+            }
+
+            if (job.Indices.size() % 3 != 0) throw std::runtime_error("TriangleMesh vertex count is not a multiple of 3");
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    void AddVertex(MeshCookJob& job, std::unordered_map<PxVec3, PxU32, VertexHash>& vertexMap, PxVec3 const& v)
+    {
+        auto it = vertexMap.find(v);
+        if (it == vertexMap.end()) {
+            it = vertexMap.insert(std::make_pair(v, (PxU32)job.Vertices.size())).first;
+            job.Vertices.push_back(v);
+        }
+
+        job.Indices.push_back(it->second);
+    }
+
+    PxVec3 LoadVertex(XmlElement& ele)
+    {
+        return PxVec3(
+            LoadProperty<PxReal>(ele, "X", 0.0f),
+            LoadProperty<PxReal>(ele, "Y", 0.0f),
+            LoadProperty<PxReal>(ele, "Z", 0.0f)
+        );
+    }
+
+    std::string MeshKey(MeshCookJob const& job)
+    {
+        auto vertexBytes = job.Vertices.size() * sizeof(PxVec3);
+        auto indexBytes = job.Indices.size() * sizeof(PxU32);
+
+        std::string key;
+        key.resize(1 + vertexBytes + indexBytes);
+        key[0] = (char)job.Type;
+        memcpy(key.data() + 1, job.Vertices.data(), vertexBytes);
+        memcpy(key.data() + 1 + vertexBytes, job.Indices.data(), indexBytes);
+        return key;
+    }
+
+    MeshCookJob& FindMesh(XmlElement& geomEle)
+    {
+        auto it = geometryMeshes_.find(geomEle.Name.data());
+        if (it == geometryMeshes_.end()) throw std::runtime_error("Mesh was not cooked");
+
+        return meshes_[it->second];
+    }
+
+    // Releases everything created so far after loading failed
+    void ReleasePartial()
+    {
+        if (collection_) {
+            // Cooked meshes and every object are added to the collection as soon as they're created
+            converter_->ReleaseCollection(collection_);
+            collection_ = nullptr;
+            return;
+        }
+
+        for (auto& mesh : meshes_) {
+            if (mesh.ConvexMesh) mesh.ConvexMesh->release();
+            if (mesh.TriangleMesh) mesh.TriangleMesh->release();
+            mesh.ConvexMesh = nullptr;
+            mesh.TriangleMesh = nullptr;
+        }
+    }
+
+    PxCollection* Load(XmlStreamReader& reader)
     {
         collection_ = PxCreateCollection();
 
-        for (auto child = doc.FirstChildElement(); child; child = child->NextSiblingElement()) {
+        for (auto& mesh : meshes_) {
+            if (mesh.ConvexMesh) collection_->add(*mesh.ConvexMesh);
+            if (mesh.TriangleMesh) collection_->add(*mesh.TriangleMesh);
+        }
+
+        // Top-level objects are parsed one at a time; the element tree of the previous
+        // object is discarded when the next one is read.
+        while (auto child = reader.ReadNextElement()) {
             LoadTopLevel(*child);
         }
 
@@ -34,34 +190,47 @@ public:
     }
 
     template <class T>
-    T LoadProperty(TiXmlElement& ele, char const* name, T defaultVal);
+    T ParseNumber(XmlElement& attr)
+    {
+        T value;
+        auto end = attr.Text + attr.TextLength;
+        auto result = std::from_chars(attr.Text, end, value);
+        if (result.ec != std::errc() || result.ptr != end) {
+            throw std::runtime_error(std::string("Invalid numeric value for property ") + std::string(attr.Name) + ": " + attr.Text);
+        }
 
-    PxReal LoadBoundedProperty(TiXmlElement& ele, char const* name, PxReal bound)
+        return value;
+    }
+
+    template <class T>
+    T LoadProperty(XmlElement& ele, char const* name, T defaultVal);
+
+    PxReal LoadBoundedProperty(XmlElement& ele, char const* name, PxReal bound)
     {
         auto attr = ele.FirstChildElement(name);
         if (attr == nullptr) return bound;
         if (strcmp(attr->GetText(), "Unbounded") == 0) return bound;
-        return std::stof(attr->GetText());
+        return ParseNumber<PxReal>(*attr);
     }
 
     template <>
-    PxReal LoadProperty(TiXmlElement& ele, char const* name, PxReal defaultVal)
+    PxReal LoadProperty(XmlElement& ele, char const* name, PxReal defaultVal)
     {
         auto attr = ele.FirstChildElement(name);
         if (attr == nullptr) return defaultVal;
-        return std::stof(attr->GetText());
+        return ParseNumber<PxReal>(*attr);
     }
 
     template <>
-    PxU32 LoadProperty(TiXmlElement& ele, char const* name, PxU32 defaultVal)
+    PxU32 LoadProperty(XmlElement& ele, char const* name, PxU32 defaultVal)
     {
         auto attr = ele.FirstChildElement(name);
         if (attr == nullptr) return defaultVal;
-        return (PxU32)std::stoi(attr->GetText());
+        return ParseNumber<PxU32>(*attr);
     }
 
     template <>
-    bool LoadProperty(TiXmlElement& ele, char const* name, bool defaultVal)
+    bool LoadProperty(XmlElement& ele, char const* name, bool defaultVal)
     {
         auto attr = ele.FirstChildElement(name);
         if (attr == nullptr) return defaultVal;
@@ -69,7 +238,7 @@ public:
     }
 
     template <>
-    std::string LoadProperty(TiXmlElement& ele, char const* name, std::string defaultVal)
+    std::string LoadProperty(XmlElement& ele, char const* name, std::string defaultVal)
     {
         auto attr = ele.FirstChildElement(name);
         if (attr == nullptr) return defaultVal;
@@ -77,10 +246,10 @@ public:
     }
 
     template <class T>
-    T LoadProperty(TiXmlElement& ele, char const* name);
+    T LoadProperty(XmlElement& ele, char const* name);
 
     template <>
-    std::string LoadProperty(TiXmlElement& ele, char const* name)
+    std::string LoadProperty(XmlElement& ele, char const* name)
     {
         auto attr = ele.FirstChildElement(name);
         if (attr == nullptr) throw std::runtime_error(std::string("Missing property: ") + name);
@@ -88,7 +257,7 @@ public:
     }
 
     template <>
-    PxD6Motion::Enum LoadProperty(TiXmlElement& ele, char const* name)
+    PxD6Motion::Enum LoadProperty(XmlElement& ele, char const* name)
     {
         auto attr = ele.FirstChildElement(name);
         if (attr == nullptr) throw std::runtime_error(std::string("Missing property: ") + name);
@@ -99,7 +268,7 @@ public:
     }
 
     template <>
-    PxTransform LoadProperty(TiXmlElement& ele, char const* name)
+    PxTransform LoadProperty(XmlElement& ele, char const* name)
     {
         auto attr = ele.FirstChildElement(name);
         PxTransform tr;
@@ -111,7 +280,7 @@ public:
     }
 
     template <>
-    PxMeshScale LoadProperty(TiXmlElement& ele, char const* name)
+    PxMeshScale LoadProperty(XmlElement& ele, char const* name)
     {
         auto attr = ele.FirstChildElement(name);
         PxMeshScale tr;
@@ -123,7 +292,7 @@ public:
     }
 
     template <>
-    PxVec3 LoadProperty(TiXmlElement& ele, char const* name)
+    PxVec3 LoadProperty(XmlElement& ele, char const* name)
     {
         auto attr = ele.FirstChildElement(name);
         PxVec3 v;
@@ -136,7 +305,7 @@ public:
     }
 
     template <>
-    PxVec3 LoadProperty(TiXmlElement& ele, char const* name, PxVec3 def)
+    PxVec3 LoadProperty(XmlElement& ele, char const* name, PxVec3 def)
     {
         auto attr = ele.FirstChildElement(name);
         if (attr == nullptr) return def;
@@ -149,7 +318,7 @@ public:
     }
 
     template <>
-    PxQuat LoadProperty(TiXmlElement& ele, char const* name)
+    PxQuat LoadProperty(XmlElement& ele, char const* name)
     {
         auto attr = ele.FirstChildElement(name);
         PxQuat v;
@@ -163,7 +332,7 @@ public:
     }
 
     template <>
-    PxJointLinearLimit LoadProperty(TiXmlElement& ele, char const* name)
+    PxJointLinearLimit LoadProperty(XmlElement& ele, char const* name)
     {
         auto attr = ele.FirstChildElement(name);
         PxJointLinearLimit v(PxTolerancesScale(), PX_MAX_F32);
@@ -179,7 +348,7 @@ public:
     }
 
     template <>
-    PxJointLinearLimitPair LoadProperty(TiXmlElement& ele, char const* name)
+    PxJointLinearLimitPair LoadProperty(XmlElement& ele, char const* name)
     {
         auto attr = ele.FirstChildElement(name);
         PxJointLinearLimitPair v(PxTolerancesScale(), -PX_MAX_F32/3, PX_MAX_F32/3);
@@ -196,7 +365,7 @@ public:
     }
 
     template <>
-    PxJointAngularLimitPair LoadProperty(TiXmlElement& ele, char const* name)
+    PxJointAngularLimitPair LoadProperty(XmlElement& ele, char const* name)
     {
         auto attr = ele.FirstChildElement(name);
         PxJointAngularLimitPair v(-PxPi / 2, PxPi / 2);
@@ -213,7 +382,7 @@ public:
     }
 
     template <>
-    PxJointLimitCone LoadProperty(TiXmlElement& ele, char const* name)
+    PxJointLimitCone LoadProperty(XmlElement& ele, char const* name)
     {
         auto attr = ele.FirstChildElement(name);
         PxJointLimitCone v(PxPi / 2, PxPi / 2);
@@ -230,7 +399,7 @@ public:
     }
 
     template <>
-    PxJointLimitPyramid LoadProperty(TiXmlElement& ele, char const* name)
+    PxJointLimitPyramid LoadProperty(XmlElement& ele, char const* name)
     {
         auto attr = ele.FirstChildElement(name);
         PxJointLimitPyramid v(-PxPi / 2, PxPi / 2, -PxPi / 2, PxPi / 2);
@@ -249,7 +418,7 @@ public:
     }
 
     template <>
-    PxD6JointDrive LoadProperty(TiXmlElement& ele, char const* name)
+    PxD6JointDrive LoadProperty(XmlElement& ele, char const* name)
     {
         auto attr = ele.FirstChildElement(name);
         PxD6JointDrive v;
@@ -262,7 +431,7 @@ public:
         return v;
     }
 
-    PxBase* LoadMaterial(TiXmlElement& ele)
+    PxBase* LoadMaterial(XmlElement& ele)
     {
         auto index = PR(Index, PxU32, 0);
         if (materials_.find(index) != materials_.end()) throw std::runtime_error("Duplicate material index");
@@ -278,7 +447,7 @@ public:
         return mat;
     }
 
-    void LoadRigidActor(TiXmlElement& ele, PxRigidActor* o)
+    void LoadRigidActor(XmlElement& ele, PxRigidActor* o)
     {
         o->setName(_strdup(PR(Name, std::string, "").c_str()));
         o->setActorFlag(PxActorFlag::eDISABLE_GRAVITY, PFLAG(DisableGravity));
@@ -294,19 +463,18 @@ public:
         actors_.insert(std::make_pair(o->getName(), o));
     }
 
-    PxBase* LoadRigidStatic(TiXmlElement& ele)
+    PxBase* LoadRigidStatic(XmlElement& ele)
     {
         auto o = physics_->createRigidStatic(
             P(GlobalPose, PxTransform)
         );
+        collection_->add(*o);
 
         LoadRigidActor(ele, o);
-
-        collection_->add(*o);
         return o;
     }
 
-    void LoadRigidBody(TiXmlElement& ele, PxRigidBody* o)
+    void LoadRigidBody(XmlElement& ele, PxRigidBody* o)
     {
         LoadRigidActor(ele, o);
 
@@ -330,11 +498,12 @@ public:
         SET_PB(MaxContactImpulse, 1e+32f);
     }
 
-    PxBase* LoadRigidDynamic(TiXmlElement& ele)
+    PxBase* LoadRigidDynamic(XmlElement& ele)
     {
         auto o = physics_->createRigidDynamic(
             P(GlobalPose, PxTransform)
         );
+        collection_->add(*o);
 
         auto minPositionIters = PR(MinPositionIters, PxU32, 4);
         auto minVelocityIters = PR(MinVelocityIters, PxU32, 1);
@@ -354,12 +523,10 @@ public:
         SET_PB(ContactReportThreshold, PX_MAX_F32);
 
         LoadRigidBody(ele, o);
-
-        collection_->add(*o);
         return o;
     }
 
-    PxShape* LoadShape(TiXmlElement& ele)
+    PxShape* LoadShape(XmlElement& ele)
     {
         auto matIndex = PR(MaterialIndex, PxU32, 0);
         auto mat = materials_.find(matIndex);
@@ -368,28 +535,28 @@ public:
         auto geomEle = ele.FirstChildElement("Geometry");
         if (!geomEle) throw std::runtime_error("Shape has no geometry");
 
-        auto geom = LoadGeometry(*geomEle);
+        std::unique_ptr<PxGeometry> geom(LoadGeometry(*geomEle));
 
         auto o = physics_->createShape(*geom, *mat->second, true);
+        collection_->add(*o);
+
         o->setName(_strdup(PR(Name, std::string, "").c_str()));
         o->setLocalPose(P(LocalPose, PxTransform));
         o->setContactOffset(PR(ContactOffset, PxReal, 0.02f));
         o->setRestOffset(PR(RestOffset, PxReal, 0.0f));
         o->setTorsionalPatchRadius(PR(TorsionalPatchRadius, PxReal, 0.0f));
         o->setMinTorsionalPatchRadius(PR(MinTorsionalPatchRadius, PxReal, 0.0f));
-
-        collection_->add(*o);
         return o;
     }
 
-    PxGeometry* LoadSphere(TiXmlElement& ele)
+    PxGeometry* LoadSphere(XmlElement& ele)
     {
         return new PxSphereGeometry(
             PR(Radius, PxReal, 1.0f)
         );
     }
 
-    PxGeometry* LoadCapsule(TiXmlElement& ele)
+    PxGeometry* LoadCapsule(XmlElement& ele)
     {
         return new PxCapsuleGeometry(
             PR(Radius, PxReal, 1.0f),
@@ -397,18 +564,17 @@ public:
         );
     }
 
-    PxGeometry* LoadBox(TiXmlElement& ele)
+    PxGeometry* LoadBox(XmlElement& ele)
     {
         return new PxBoxGeometry(
             P(HalfExtents, PxVec3)
         );
     }
 
-    PxGeometry* LoadConvexMeshGeometry(TiXmlElement& ele)
+    PxGeometry* LoadConvexMeshGeometry(XmlElement& ele)
     {
-        auto meshEle = ele.FirstChildElement("ConvexMesh");
-        if (!meshEle) throw std::runtime_error("Geometry has no ConvexMesh");
-        auto mesh = LoadConvexMesh(ele);
+        if (!ele.FirstChildElement("ConvexMesh")) throw std::runtime_error("Geometry has no ConvexMesh");
+        auto mesh = FindMesh(ele).ConvexMesh;
 
         return new PxConvexMeshGeometry(
             mesh,
@@ -416,11 +582,10 @@ public:
         );
     }
 
-    PxGeometry* LoadTriangleMeshGeometry(TiXmlElement& ele)
+    PxGeometry* LoadTriangleMeshGeometry(XmlElement& ele)
     {
-        auto meshEle = ele.FirstChildElement("TriangleMesh");
-        if (!meshEle) throw std::runtime_error("Geometry has no TriangleMesh");
-        auto mesh = LoadTriangleMesh(ele);
+        if (!ele.FirstChildElement("TriangleMesh")) throw std::runtime_error("Geometry has no TriangleMesh");
+        auto mesh = FindMesh(ele).TriangleMesh;
 
         return new PxTriangleMeshGeometry(
             mesh,
@@ -428,17 +593,7 @@ public:
         );
     }
 
-    PxConvexMesh* LoadConvexMesh(TiXmlElement& ele)
-    {
-        throw new std::runtime_error("LoadConvexMesh: Dont know how to do this yet");
-    }
-
-    PxTriangleMesh* LoadTriangleMesh(TiXmlElement& ele)
-    {
-        throw new std::runtime_error("LoadTriangleMesh: Dont know how to do this yet");
-    }
-
-    PxGeometry* LoadGeometry(TiXmlElement& ele)
+    PxGeometry* LoadGeometry(XmlElement& ele)
     {
         auto type = PR(Type, std::string, "");
 
@@ -457,7 +612,7 @@ public:
         }
     }
 
-    void LoadJoint(PxJoint* o, TiXmlElement& ele)
+    void LoadJoint(PxJoint* o, XmlElement& ele)
     {
         o->setName(_strdup(PR(Name, std::string, "").c_str()));
 
@@ -476,7 +631,7 @@ public:
         SET_PR(InvInertiaScale1, PxReal, 1.0f);
     }
 
-    PxBase* LoadD6Joint(TiXmlElement& ele)
+    PxBase* LoadD6Joint(XmlElement& ele)
     {
         auto actor0Name = P(Actor0, std::string);
         auto actor1Name = P(Actor1, std::string);
@@ -491,6 +646,9 @@ public:
         auto pose1 = P(Actor1LocalPose, PxTransform);
 
         auto o = PxD6JointCreate(*physics_, actor0It->second, pose0, actor1It->second, pose1);
+        collection_->add(*o->getConstraint());
+        collection_->add(*o);
+
         LoadJoint(o, ele);
 
         o->setMotion(PxD6Axis::eX, P(MotionX, PxD6Motion::Enum));
@@ -517,14 +675,13 @@ public:
 
         SET_PR(ProjectionLinearTolerance, PxReal, 1e+10f);
         SET_PR(ProjectionAngularTolerance, PxReal, 3.14159f);
-
-        collection_->add(*o->getConstraint());
-        collection_->add(*o);
         return o;
     }
 
-    PxBase* LoadArticulationJoint(TiXmlElement& ele, PxArticulationJoint* o)
+    PxBase* LoadArticulationJoint(XmlElement& ele, PxArticulationJoint* o)
     {
+        collection_->add(*o);
+
         SET_P(ParentPose, PxTransform);
         SET_P(ChildPose, PxTransform);
 
@@ -544,16 +701,15 @@ public:
 
         SET_PR(TwistLimitContactDistance, PxReal, 0.05f);
         SET_PR(TwistLimitEnabled, bool, false);
-
-        collection_->add(*o);
         return o;
     }
 
-    PxBase* LoadArticulationLink(TiXmlElement& ele, PxArticulation& articulation, PxArticulationLink* parent)
+    PxBase* LoadArticulationLink(XmlElement& ele, PxArticulation& articulation, PxArticulationLink* parent)
     {
         auto o = articulation.createLink(
             parent, P(GlobalPose, PxTransform)
         );
+        collection_->add(*o);
 
         LoadRigidBody(ele, o);
 
@@ -563,8 +719,6 @@ public:
             LoadArticulationJoint(*jointNode, static_cast<PxArticulationJoint*>(o->getInboundJoint()));
         }
 
-        collection_->add(*o);
-
         auto linksNode = ele.FirstChildElement("Links");
         if (linksNode) {
             for (auto linkNode = linksNode->FirstChildElement("Link"); linkNode; linkNode = linkNode->NextSiblingElement("Link")) {
@@ -575,9 +729,10 @@ public:
         return o;
     }
 
-    PxBase* LoadArticulation(TiXmlElement& ele)
+    PxBase* LoadArticulation(XmlElement& ele)
     {
         auto o = physics_->createArticulation();
+        collection_->add(*o);
 
         SET_PR(SleepThreshold, PxReal, 0.005f);
         SET_PR(StabilizationThreshold, PxReal, 0.0025f);
@@ -596,11 +751,10 @@ public:
             }
         }
 
-        collection_->add(*o);
         return o;
     }
 
-    PxBase* LoadTopLevel(TiXmlElement& ele)
+    PxBase* LoadTopLevel(XmlElement& ele)
     {
         auto type = ele.ValueStr();
         if (type == "Material") {
@@ -621,21 +775,22 @@ public:
 };
 
 
-PxCollection* PhysXConverter::LoadCollectionFromXml(std::span<uint8_t> const& xml)
+PxCollection* PhysXConverter::LoadCollectionFromXml(std::span<uint8_t const> xml)
 {
     PhysXLoader loader;
+    loader.converter_ = this;
     loader.physics_ = physics_;
     loader.cooking_ = cooking_;
 
-    // Ensure string is null-terminated
-    std::string s((char const*)xml.data(), xml.size());
+    try {
+        loader.CookMeshes(xml);
 
-    TiXmlDocument doc;
-    doc.Parse(s.c_str(), 0, TIXML_ENCODING_UTF8);
-    if (doc.Error()) throw std::runtime_error(doc.ErrorDesc());
+        XmlStreamReader reader(xml);
+        if (reader.ReadRootElement() != "BG3Physics") throw std::runtime_error("Expected a BG3Physics XML document");
 
-    auto root = doc.FirstChildElement();
-    if (root == nullptr || strcmp(root->Value(), "BG3Physics") != 0) throw std::runtime_error("Expected a BG3Physics XML document");
-
-    return loader.Load(*root);
+        return loader.Load(reader);
+    } catch (...) {
+        loader.ReleasePartial();
+        throw;
+    }
 }
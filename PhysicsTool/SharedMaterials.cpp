@@ -0,0 +1,112 @@
+#include "PhysicsTool.h"
+
+std::size_t MaterialKeyHash::operator()(MaterialKey const& key) const
+{
+    std::hash<PxReal> hf;
+    std::hash<uint32_t> hi;
+    std::size_t hash = hf(key.StaticFriction);
+    hash = hash * 31 + hf(key.DynamicFriction);
+    hash = hash * 31 + hf(key.Restitution);
+    hash = hash * 31 + hi(key.Flags);
+    hash = hash * 31 + hi(key.FrictionCombineMode);
+    hash = hash * 31 + hi(key.RestitutionCombineMode);
+    return hash;
+}
+
+
+SharedMaterials::SharedMaterials(PxPhysics& physics)
+    : physics_(physics)
+{
+    collection_ = PxCreateCollection();
+}
+
+
+SharedMaterials::~SharedMaterials()
+{
+    collection_->release();
+    for (auto& mat : materials_) {
+        mat.second->release();
+    }
+}
+
+
+PxMaterial* SharedMaterials::GetShared(PxMaterial& material)
+{
+    MaterialKey key{
+        material.getStaticFriction(),
+        material.getDynamicFriction(),
+        material.getRestitution(),
+        (uint32_t)material.getFlags(),
+        (uint32_t)material.getFrictionCombineMode(),
+        (uint32_t)material.getRestitutionCombineMode()
+    };
+
+    auto it = materials_.find(key);
+    if (it != materials_.end()) return it->second;
+
+    auto shared = physics_.createMaterial(key.StaticFriction, key.DynamicFriction, key.Restitution);
+    shared->setFlags(material.getFlags());
+    shared->setFrictionCombineMode(material.getFrictionCombineMode());
+    shared->setRestitutionCombineMode(material.getRestitutionCombineMode());
+
+    collection_->add(*shared, MakeSerialId(key));
+    materials_.insert(std::make_pair(key, shared));
+    return shared;
+}
+
+
+PxSerialObjectId SharedMaterials::MakeSerialId(MaterialKey const& key) const
+{
+    // Hash each field separately so padding never affects the ID
+    XxHash64 hash;
+    hash.Update(&key.StaticFriction, sizeof(key.StaticFriction));
+    hash.Update(&key.DynamicFriction, sizeof(key.DynamicFriction));
+    hash.Update(&key.Restitution, sizeof(key.Restitution));
+    hash.Update(&key.Flags, sizeof(key.Flags));
+    hash.Update(&key.FrictionCombineMode, sizeof(key.FrictionCombineMode));
+    hash.Update(&key.RestitutionCombineMode, sizeof(key.RestitutionCombineMode));
+
+    // 0 is the invalid ID. A hash collision between two different materials is resolved by
+    // probing, which is the only case where the ID depends on the order materials were added.
+    PxSerialObjectId id = hash.Digest();
+    while (id == PX_SERIAL_OBJECT_ID_INVALID || collection_->find(id) != nullptr) {
+        id++;
+    }
+
+    return id;
+}
+
+
+void SharedMaterials::Share(PxCollection& collection)
+{
+    std::vector<PxMaterial*> localMaterials;
+    std::vector<PxMaterial*> shapeMaterials;
+
+    for (PxU32 i = 0; i < collection.getNbObjects(); i++) {
+        auto& obj = collection.getObject(i);
+        if (auto material = obj.is<PxMaterial>()) {
+            localMaterials.push_back(material);
+        } else if (auto shape = obj.is<PxShape>()) {
+            shapeMaterials.resize(shape->getNbMaterials());
+            shape->getMaterials(shapeMaterials.data(), (PxU32)shapeMaterials.size(), 0);
+            for (auto& mat : shapeMaterials) {
+                mat = GetShared(*mat);
+            }
+
+            shape->setMaterials(shapeMaterials.data(), (PxU16)shapeMaterials.size());
+        }
+    }
+
+    for (auto material : localMaterials) {
+        collection.remove(*material);
+        material->release();
+    }
+
+    numReplaced_ += (uint32_t)localMaterials.size();
+}
+
+
+std::unique_ptr<SharedMaterials> PhysXConverter::CreateSharedMaterials()
+{
+    return std::make_unique<SharedMaterials>(*physics_);
+}
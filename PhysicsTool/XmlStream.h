@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class XxHash64;
+
+// Bump allocator for XML nodes. Memory is reused between top-level elements, so the
+// footprint is bounded by the largest single object in the document.
+class XmlArena
+{
+public:
+    void* Allocate(std::size_t size, std::size_t align);
+    char const* CopyString(std::string_view s);
+    void Reset();
+
+    template <class T>
+    T* New()
+    {
+        return new (Allocate(sizeof(T), alignof(T))) T();
+    }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<uint8_t[]> data;
+        std::size_t size{ 0 };
+    };
+
+    static constexpr std::size_t MinBlockSize = 0x10000;
+
+    std::vector<Block> blocks_;
+    std::size_t used_{ 0 };
+    std::size_t totalSize_{ 0 };
+};
+
+
+// Lightweight element node; mirrors the subset of the TinyXML API used by the loader.
+class XmlElement
+{
+public:
+    std::string_view Name;
+    char const* Text{ "" };
+    std::size_t TextLength{ 0 };
+    XmlElement* FirstChild{ nullptr };
+    XmlElement* LastChild{ nullptr };
+    XmlElement* NextSibling{ nullptr };
+
+    inline std::string_view ValueStr() const
+    {
+        return Name;
+    }
+
+    inline char const* GetText() const
+    {
+        return Text;
+    }
+
+    XmlElement* FirstChildElement() const;
+    XmlElement* FirstChildElement(char const* name) const;
+    XmlElement* NextSiblingElement() const;
+    XmlElement* NextSiblingElement(char const* name) const;
+};
+
+
+// Pull parser that reads the children of the document element one at a time.
+// Each call to ReadNextElement() invalidates the element returned by the previous call.
+class XmlStreamReader
+{
+public:
+    XmlStreamReader(std::span<uint8_t const> xml);
+
+    std::string_view ReadRootElement();
+    XmlElement* ReadNextElement();
+
+private:
+    static constexpr uint32_t MaxDepth = 1024;
+
+    char const* begin_;
+    char const* cur_;
+    char const* end_;
+    std::string_view root_;
+    bool rootClosed_{ false };
+    XmlArena arena_;
+    std::string text_;
+
+    [[noreturn]] void Error(char const* msg) const;
+    bool StartsWith(std::string_view s) const;
+    void Expect(std::string_view s);
+    void SkipWhitespace();
+    void SkipUntil(std::string_view terminator);
+    void SkipMisc();
+    std::string_view ReadName();
+    bool ReadStartTag(std::string_view& name);
+    void ReadEndTag(std::string_view name);
+    void ReadText(std::string& text);
+    void CommitText(XmlElement& ele);
+    XmlElement* ReadElement(uint32_t depth);
+};
+
+
+// Streaming writer that appends escaped markup directly into a growable output buffer.
+// Element names are not copied and must outlive the enclosing element.
+class XmlStreamWriter
+{
+public:
+    XmlStreamWriter(std::size_t reserveSize = 0x10000);
+
+    void WriteDeclaration();
+    void BeginElement(std::string_view name);
+    void EndElement();
+    void WriteElement(std::string_view name, std::string_view text);
+    void WriteReal(std::string_view name, float value);
+    void WriteInteger(std::string_view name, uint64_t value);
+
+    inline std::vector<uint8_t> Release()
+    {
+        return std::move(buf_);
+    }
+
+    // Feeds the markup into a hash instead of the output buffer; indentation is omitted
+    inline void HashOnly(XxHash64& hash)
+    {
+        hash_ = &hash;
+    }
+
+private:
+    std::vector<uint8_t> buf_;
+    XxHash64* hash_{ nullptr };
+    std::vector<std::string_view> elements_;
+    bool startTagOpen_{ false };
+
+    void Append(std::string_view s);
+    void AppendEscaped(std::string_view s);
+    void Indent();
+    void CloseStartTag();
+};
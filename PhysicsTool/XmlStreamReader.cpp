@@ -0,0 +1,347 @@
+#include "XmlStream.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+
+void* XmlArena::Allocate(std::size_t size, std::size_t align)
+{
+    if (!blocks_.empty()) {
+        auto& block = blocks_.back();
+        auto offset = (used_ + align - 1) & ~(align - 1);
+        if (offset + size <= block.size) {
+            used_ = offset + size;
+            return block.data.get() + offset;
+        }
+    }
+
+    Block block;
+    block.size = std::max(MinBlockSize, size + align);
+    block.data.reset(new uint8_t[block.size]);
+    totalSize_ += block.size;
+    blocks_.push_back(std::move(block));
+    used_ = 0;
+
+    return Allocate(size, align);
+}
+
+
+char const* XmlArena::CopyString(std::string_view s)
+{
+    auto str = reinterpret_cast<char*>(Allocate(s.size() + 1, 1));
+    memcpy(str, s.data(), s.size());
+    str[s.size()] = 0;
+    return str;
+}
+
+
+void XmlArena::Reset()
+{
+    if (blocks_.size() > 1) {
+        // Coalesce into a single block that can hold the largest object seen so far
+        Block block;
+        block.size = totalSize_;
+        block.data.reset(new uint8_t[block.size]);
+        blocks_.clear();
+        blocks_.push_back(std::move(block));
+    }
+
+    used_ = 0;
+}
+
+
+XmlElement* XmlElement::FirstChildElement() const
+{
+    return FirstChild;
+}
+
+
+XmlElement* XmlElement::FirstChildElement(char const* name) const
+{
+    for (auto child = FirstChild; child; child = child->NextSibling) {
+        if (child->Name == name) return child;
+    }
+
+    return nullptr;
+}
+
+
+XmlElement* XmlElement::NextSiblingElement() const
+{
+    return NextSibling;
+}
+
+
+XmlElement* XmlElement::NextSiblingElement(char const* name) const
+{
+    for (auto sibling = NextSibling; sibling; sibling = sibling->NextSibling) {
+        if (sibling->Name == name) return sibling;
+    }
+
+    return nullptr;
+}
+
+
+XmlStreamReader::XmlStreamReader(std::span<uint8_t const> xml)
+    : begin_(reinterpret_cast<char const*>(xml.data())),
+    cur_(begin_),
+    end_(begin_ + xml.size())
+{
+    // Skip UTF-8 byte order mark
+    if (StartsWith("\xEF\xBB\xBF")) cur_ += 3;
+}
+
+
+void XmlStreamReader::Error(char const* msg) const
+{
+    auto line = 1 + std::count(begin_, cur_, '\n');
+    throw std::runtime_error(std::string("XML parse error on line ") + std::to_string(line) + ": " + msg);
+}
+
+
+bool XmlStreamReader::StartsWith(std::string_view s) const
+{
+    return (std::size_t)(end_ - cur_) >= s.size() && memcmp(cur_, s.data(), s.size()) == 0;
+}
+
+
+void XmlStreamReader::Expect(std::string_view s)
+{
+    if (!StartsWith(s)) Error("Malformed markup");
+    cur_ += s.size();
+}
+
+
+void XmlStreamReader::SkipWhitespace()
+{
+    while (cur_ < end_ && (*cur_ == ' ' || *cur_ == '\t' || *cur_ == '\r' || *cur_ == '\n')) {
+        cur_++;
+    }
+}
+
+
+void XmlStreamReader::SkipUntil(std::string_view terminator)
+{
+    auto pos = std::string_view(cur_, end_ - cur_).find(terminator);
+    if (pos == std::string_view::npos) Error("Unterminated markup");
+    cur_ += pos + terminator.size();
+}
+
+
+void XmlStreamReader::SkipMisc()
+{
+    for (;;) {
+        SkipWhitespace();
+        if (StartsWith("<?")) {
+            SkipUntil("?>");
+        } else if (StartsWith("<!--")) {
+            SkipUntil("-->");
+        } else if (StartsWith("<!DOCTYPE")) {
+            SkipUntil(">");
+        } else {
+            return;
+        }
+    }
+}
+
+
+std::string_view XmlStreamReader::ReadName()
+{
+    auto start = cur_;
+    while (cur_ < end_ && *cur_ != ' ' && *cur_ != '\t' && *cur_ != '\r' && *cur_ != '\n'
+        && *cur_ != '/' && *cur_ != '>' && *cur_ != '=' && *cur_ != '<') {
+        cur_++;
+    }
+
+    if (cur_ == start) Error("Expected a name");
+    return std::string_view(start, cur_ - start);
+}
+
+
+bool XmlStreamReader::ReadStartTag(std::string_view& name)
+{
+    Expect("<");
+    name = ReadName();
+
+    for (;;) {
+        SkipWhitespace();
+        if (StartsWith("/>")) {
+            cur_ += 2;
+            return true;
+        }
+
+        if (StartsWith(">")) {
+            cur_++;
+            return false;
+        }
+
+        // Attributes are not used by the physics format, skip them
+        ReadName();
+        SkipWhitespace();
+        Expect("=");
+        SkipWhitespace();
+        if (cur_ >= end_ || (*cur_ != '"' && *cur_ != '\'')) Error("Expected quoted attribute value");
+        char quote[2] = { *cur_++, 0 };
+        SkipUntil(quote);
+    }
+}
+
+
+void XmlStreamReader::ReadEndTag(std::string_view name)
+{
+    Expect("</");
+    if (ReadName() != name) Error("Mismatched end tag");
+    SkipWhitespace();
+    Expect(">");
+}
+
+
+void XmlStreamReader::ReadText(std::string& text)
+{
+    while (cur_ < end_ && *cur_ != '<') {
+        if (*cur_ != '&') {
+            auto run = cur_;
+            while (cur_ < end_ && *cur_ != '<' && *cur_ != '&') cur_++;
+            text.append(run, cur_);
+            continue;
+        }
+
+        auto semicolon = std::find(cur_, std::min(end_, cur_ + 12), ';');
+        if (semicolon == end_ || *semicolon != ';') Error("Unterminated entity reference");
+        std::string_view entity(cur_ + 1, semicolon - cur_ - 1);
+
+        if (entity == "lt") {
+            text += '<';
+        } else if (entity == "gt") {
+            text += '>';
+        } else if (entity == "amp") {
+            text += '&';
+        } else if (entity == "quot") {
+            text += '"';
+        } else if (entity == "apos") {
+            text += '\'';
+        } else if (entity.size() > 1 && entity[0] == '#') {
+            uint32_t codepoint;
+            auto hex = (entity[1] == 'x' || entity[1] == 'X');
+            auto digits = entity.substr(hex ? 2 : 1);
+            auto result = std::from_chars(digits.data(), digits.data() + digits.size(), codepoint, hex ? 16 : 10);
+            if (result.ec != std::errc() || result.ptr != digits.data() + digits.size() || codepoint > 0x10FFFF) {
+                Error("Invalid character reference");
+            }
+
+            if (codepoint < 0x80) {
+                text += (char)codepoint;
+            } else if (codepoint < 0x800) {
+                text += (char)(0xC0 | (codepoint >> 6));
+                text += (char)(0x80 | (codepoint & 0x3F));
+            } else if (codepoint < 0x10000) {
+                text += (char)(0xE0 | (codepoint >> 12));
+                text += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+                text += (char)(0x80 | (codepoint & 0x3F));
+            } else {
+                text += (char)(0xF0 | (codepoint >> 18));
+                text += (char)(0x80 | ((codepoint >> 12) & 0x3F));
+                text += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+                text += (char)(0x80 | (codepoint & 0x3F));
+            }
+        } else {
+            Error("Unknown entity reference");
+        }
+
+        cur_ = semicolon + 1;
+    }
+}
+
+
+void XmlStreamReader::CommitText(XmlElement& ele)
+{
+    auto first = text_.find_first_not_of(" \t\r\n");
+    if (first != std::string::npos && ele.TextLength == 0) {
+        auto last = text_.find_last_not_of(" \t\r\n");
+        std::string_view trimmed(text_.data() + first, last - first + 1);
+        ele.Text = arena_.CopyString(trimmed);
+        ele.TextLength = trimmed.size();
+    }
+
+    text_.clear();
+}
+
+
+XmlElement* XmlStreamReader::ReadElement(uint32_t depth)
+{
+    if (depth > MaxDepth) Error("Elements are nested too deeply");
+
+    auto ele = arena_.New<XmlElement>();
+    if (ReadStartTag(ele->Name)) return ele;
+
+    text_.clear();
+    for (;;) {
+        if (cur_ >= end_) Error("Unexpected end of document");
+
+        if (*cur_ != '<') {
+            ReadText(text_);
+        } else if (StartsWith("</")) {
+            CommitText(*ele);
+            ReadEndTag(ele->Name);
+            return ele;
+        } else if (StartsWith("<!--")) {
+            SkipUntil("-->");
+        } else if (StartsWith("<![CDATA[")) {
+            cur_ += 9;
+            auto start = cur_;
+            SkipUntil("]]>");
+            text_.append(start, cur_ - 3);
+        } else if (StartsWith("<?")) {
+            SkipUntil("?>");
+        } else {
+            CommitText(*ele);
+            auto child = ReadElement(depth + 1);
+            if (ele->LastChild) {
+                ele->LastChild->NextSibling = child;
+            } else {
+                ele->FirstChild = child;
+            }
+            ele->LastChild = child;
+        }
+    }
+}
+
+
+std::string_view XmlStreamReader::ReadRootElement()
+{
+    SkipMisc();
+    if (cur_ >= end_) Error("Document has no root element");
+
+    rootClosed_ = ReadStartTag(root_);
+    return root_;
+}
+
+
+XmlElement* XmlStreamReader::ReadNextElement()
+{
+    arena_.Reset();
+    if (rootClosed_) return nullptr;
+    if (root_.empty()) Error("Root element was not read");
+
+    for (;;) {
+        SkipWhitespace();
+        if (cur_ >= end_) Error("Unexpected end of document");
+
+        if (StartsWith("</")) {
+            ReadEndTag(root_);
+            rootClosed_ = true;
+            SkipMisc();
+            if (cur_ < end_) Error("Unexpected content after document element");
+            return nullptr;
+        } else if (StartsWith("<!--")) {
+            SkipUntil("-->");
+        } else if (StartsWith("<?")) {
+            SkipUntil("?>");
+        } else if (*cur_ == '<') {
+            return ReadElement(1);
+        } else {
+            Error("Unexpected text in document element");
+        }
+    }
+}
@@ -0,0 +1,146 @@
+#include "XmlStream.h"
+#include "Fingerprint.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+
+
+XmlStreamWriter::XmlStreamWriter(std::size_t reserveSize)
+{
+    buf_.reserve(reserveSize);
+}
+
+
+void XmlStreamWriter::WriteDeclaration()
+{
+    Append("<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n");
+}
+
+
+void XmlStreamWriter::BeginElement(std::string_view name)
+{
+    CloseStartTag();
+    Indent();
+    Append("<");
+    Append(name);
+
+    elements_.push_back(name);
+    startTagOpen_ = true;
+}
+
+
+void XmlStreamWriter::EndElement()
+{
+    auto name = elements_.back();
+    elements_.pop_back();
+
+    if (startTagOpen_) {
+        // Element has no children
+        Append(" />\n");
+        startTagOpen_ = false;
+    } else {
+        Indent();
+        Append("</");
+        Append(name);
+        Append(">\n");
+    }
+}
+
+
+void XmlStreamWriter::WriteElement(std::string_view name, std::string_view text)
+{
+    CloseStartTag();
+    Indent();
+    Append("<");
+    Append(name);
+    Append(">");
+    AppendEscaped(text);
+    Append("</");
+    Append(name);
+    Append(">\n");
+}
+
+
+void XmlStreamWriter::WriteReal(std::string_view name, float value)
+{
+    // Shortest representation that round-trips to the same float
+    char val[32];
+    auto result = std::to_chars(val, val + sizeof(val), value);
+    WriteElement(name, std::string_view(val, result.ptr - val));
+}
+
+
+void XmlStreamWriter::WriteInteger(std::string_view name, uint64_t value)
+{
+    char val[24];
+    auto result = std::to_chars(val, val + sizeof(val), value);
+    WriteElement(name, std::string_view(val, result.ptr - val));
+}
+
+
+void XmlStreamWriter::Append(std::string_view s)
+{
+    if (hash_) {
+        hash_->Update(s.data(), s.size());
+        return;
+    }
+
+    auto p = reinterpret_cast<uint8_t const*>(s.data());
+    buf_.insert(buf_.end(), p, p + s.size());
+}
+
+
+void XmlStreamWriter::AppendEscaped(std::string_view s)
+{
+    std::size_t run = 0;
+    for (std::size_t i = 0; i < s.size(); i++) {
+        auto c = (uint8_t)s[i];
+        char const* entity = nullptr;
+        char charRef[8];
+
+        switch (c) {
+        case '<': entity = "&lt;"; break;
+        case '>': entity = "&gt;"; break;
+        case '&': entity = "&amp;"; break;
+        case '"': entity = "&quot;"; break;
+        case '\'': entity = "&apos;"; break;
+        default:
+            if (c < 0x20 && c != '\t' && c != '\n' && c != '\r') {
+                snprintf(charRef, sizeof(charRef), "&#x%02X;", c);
+                entity = charRef;
+            }
+            break;
+        }
+
+        if (entity != nullptr) {
+            Append(s.substr(run, i - run));
+            Append(entity);
+            run = i + 1;
+        }
+    }
+
+    Append(s.substr(run));
+}
+
+
+void XmlStreamWriter::Indent()
+{
+    if (hash_) return;
+
+    static constexpr std::string_view indent = "                                ";
+    auto depth = elements_.size() * 4;
+    while (depth > 0) {
+        auto chunk = std::min(depth, indent.size());
+        Append(indent.substr(0, chunk));
+        depth -= chunk;
+    }
+}
+
+
+void XmlStreamWriter::CloseStartTag()
+{
+    if (startTagOpen_) {
+        Append(">\n");
+        startTagOpen_ = false;
+    }
+}
@@ -61,6 +61,13 @@ namespace LSTools.StoryCompiler
         )]
         public string GameDataPath;
 
+        [ValueArgument(typeof(string), "vfs-snapshot",
+            Description = "Cache the game package file list in this file to speed up later runs",
+            ValueOptional = false,
+            Optional = true
+        )]
+        public string VFSSnapshotPath;
+
         [ValueArgument(typeof(string), "output",
             Description = "Output path",
             DefaultValue = "story.div.osi",
@@ -35,6 +35,7 @@ class ModCompiler : IDisposable
     public bool CheckOnly = false;
     public bool CheckGameObjects = false;
     public bool LoadPackages = true;
+    public string VFSSnapshotPath = null;
     public bool AllowTypeCoercion = false;
     public bool OsiExtender = false;
     public TargetGame Game = TargetGame.DOS2;
@@ -310,7 +311,10 @@ class ModCompiler : IDisposable
         if (mods.Count > 0)
         {
             Logger.TaskStarted("Building VFS");
-            FS = new VFS();
+            FS = new VFS
+            {
+                SnapshotPath = VFSSnapshotPath
+            };
             if (LoadPackages)
             {
                 FS.AttachGameDirectory(GameDataPath);
@@ -45,6 +45,7 @@ class Program
             modCompiler.CheckGameObjects = args.CheckGameObjects;
             modCompiler.CheckOnly = args.CheckOnly;
             modCompiler.LoadPackages = !args.NoPackages;
+            modCompiler.VFSSnapshotPath = args.VFSSnapshotPath;
             modCompiler.AllowTypeCoercion = args.AllowTypeCoercion;
             modCompiler.OsiExtender = args.OsiExtender;
             if (args.Game == "dos2")